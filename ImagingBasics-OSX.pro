@@ -1,4 +1,4 @@
-QT += core gui
+QT += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
@@ -7,27 +7,19 @@ TEMPLATE = app
 
 QMAKE_MACOSX_DEPLOYMENT_TARGET = 10.12
 
-INCLUDEPATH += /opt/local/include/
-
-LIBS += -L/opt/local/lib \
-    -lopencv_core \
-    -lopencv_imgproc \
-    -lopencv_highgui \
-    -lopencv_ml \
-    -lopencv_video \
-    -lopencv_features2d \
-    -lopencv_calib3d \
-    -lopencv_objdetect \
-    -lopencv_flann \
-    -lopencv_imgcodecs
-
+include(build.pri)
+include(opencv.pri)
 include(res/res.pri)
 include(gui/gui.pri)
 include(myimage/myimage.pri)
+include(cli/cli.pri)
 
 DISTFILES += \
+    build.pri \
+    opencv.pri \
     res/res.pri \
     gui/gui.pri \
-    myimage/myimage.pri
+    myimage/myimage.pri \
+    cli/cli.pri
 
 SOURCES += main.cpp
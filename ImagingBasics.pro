@@ -0,0 +1,27 @@
+# all targets on any platform:
+#   qmake ImagingBasics.pro [CONFIG+=lto] [CONFIG+=myimage_shared] [MARCH=native] [OPENCV_DIR=...]
+#                           [CONFIG+=python [PYTHON=python3]]
+# myimage is the image engine library, gui the application, cli the headless tool without any
+# widgets, bench the kernel benchmark and python the optional numpy extension module; make check
+# builds everything and runs the golden image tests of bench
+
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    myimage \
+    gui \
+    cli \
+    bench
+
+gui.depends = myimage
+cli.depends = myimage
+bench.depends = myimage
+
+python {
+    SUBDIRS += python
+    python.depends = myimage
+}
+
+DISTFILES += \
+    build.pri \
+    opencv.pri
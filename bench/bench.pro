@@ -0,0 +1,32 @@
+# kernel benchmark, IMAGING_BASICS_SIMD compares instruction set levels on one machine;
+# --golden-check compares every operation against the golden outputs in golden/, and
+# --golden-time-record and --golden-time-check keep per machine time budgets apart from them
+
+QT = core gui
+
+TARGET = imaging-basics-bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../build.pri)
+include(../myimage/myimage-lib.pri)
+
+SOURCES += \
+    main.cpp \
+    mygolden.cpp
+
+HEADERS += \
+    mygolden.h
+
+DISTFILES += \
+    golden/make_golden.py
+
+# make check runs the golden pixel and histogram comparison, no timings, so it is safe on any
+# machine; GOLDEN_SAMPLES and GOLDEN_DIR point it elsewhere
+isEmpty(GOLDEN_SAMPLES): GOLDEN_SAMPLES = $$PWD/golden/samples
+isEmpty(GOLDEN_DIR): GOLDEN_DIR = $$PWD/golden
+
+check.depends = $(TARGET)
+check.commands = $$shell_path(./$(TARGET)) --golden-check $$shell_quote($$GOLDEN_SAMPLES) $$shell_quote($$GOLDEN_DIR)
+QMAKE_EXTRA_TARGETS += check
@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+# writes the golden samples, outputs and golden.txt of bench/golden from a plain reference of the
+# 8 bit operations, independent of the lookup, SIMD and parallel code of MyImage:
+#
+#   python3 bench/golden/make_golden.py [bench/golden]
+#
+# every operation follows the definition in myimage.h and mytransform.h pixel by pixel, rounding
+# included, so imaging-basics-bench --golden-check compares the engine against this reference and
+# not against an earlier build of itself
+
+import math
+import os
+import struct
+import sys
+import zlib
+
+BINS = 256
+MAX_BIN = 255
+
+
+# ----- SAMPLES ----------------------------------------------------------------------------------
+def make_ramp():
+    # every level at least once, the full range for the point transforms
+    rows, cols = 48, 64
+    return [[(row * cols + col) * MAX_BIN // (rows * cols - 1) for col in range(cols)] for row in range(rows)]
+
+
+def make_noise():
+    # low contrast noise from a fixed linear congruential generator, for equalize and auto contrast
+    rows, cols = 64, 64
+    state = 12345
+    image = []
+    for row in range(rows):
+        line = []
+        for col in range(cols):
+            state = (state * 1103515245 + 12345) & 0x7fffffff
+            line.append(60 + (state >> 16) % 81)
+        image.append(line)
+    return image
+
+
+def make_shapes():
+    # a few flat regions with hard edges, for the tiles and windows of the local operations
+    rows, cols = 60, 80
+    image = []
+    for row in range(rows):
+        line = []
+        for col in range(cols):
+            value = 30
+            if 10 <= row < 30 and 8 <= col < 40:
+                value = 200
+            if (row - 40) ** 2 + (col - 55) ** 2 < 144:
+                value = 120
+            if col >= 70:
+                value = 250 - 2 * row
+            line.append(value)
+        image.append(line)
+    return image
+
+
+# ----- FILES ------------------------------------------------------------------------------------
+def write_pgm(path, image):
+    with open(path, "wb") as file:
+        file.write(b"P5\n%d %d\n255\n" % (len(image[0]), len(image)))
+        file.write(bytes(value for line in image for value in line))
+
+
+def write_png(path, image):
+    # 8 bit grayscale, filter 0 on every row
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data) & 0xffffffff)
+
+    raw = b"".join(b"\x00" + bytes(line) for line in image)
+    header = struct.pack(">IIBBBBB", len(image[0]), len(image), 8, 0, 0, 0, 0)
+    with open(path, "wb") as file:
+        file.write(b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", header) + chunk(b"IDAT", zlib.compress(raw, 9)) +
+                   chunk(b"IEND", b""))
+
+
+# ----- HISTOGRAMS -------------------------------------------------------------------------------
+def histogram(image):
+    counts = [0] * BINS
+    for line in image:
+        for value in line:
+            counts[value] += 1
+    return counts
+
+
+def cdf(counts):
+    total = sum(counts)
+    result = []
+    running = 0
+    for count in counts:
+        running += count
+        result.append(running / total)
+    return result
+
+
+def equalization_transform(counts):
+    # MyImage::buildIntensityCumulative, integer rounding
+    total = sum(counts)
+    result = []
+    running = 0
+    for count in counts:
+        running += count
+        result.append((running * MAX_BIN + total // 2) // total)
+    return result
+
+
+def percentile(counts, percent):
+    # MyStatistics::getPercentile, nearest rank
+    count = float(sum(counts))
+    rank = max(1.0, math.ceil(min(100.0, max(0.0, percent)) / 100 * count))
+    running = 0.0
+    for i, value in enumerate(counts):
+        running += value
+        if running >= rank:
+            return i
+    return BINS
+
+
+# ----- POINT TRANSFORMS -------------------------------------------------------------------------
+def c_round(value):
+    # round half away from zero like C, the tables are never negative
+    lower = math.floor(value)
+    return lower + 1 if value - lower >= 0.5 else lower
+
+
+def lookup_from(op):
+    # MyImage::buildIntensityLookup and rebinIntensityCalculation, then the uchar table
+    table = [op(float(i)) for i in range(BINS)]
+    low = float(MAX_BIN)
+    high = 0.0
+    for value in table:
+        high = value if value > high else high
+        low = value if value < low else low
+    if high > 0:
+        table = [(MAX_BIN / high) * (value - low + 0) for value in table]
+    return [int(c_round(value)) for value in table]
+
+
+def point(image, op):
+    table = lookup_from(op)
+    return [[table[value] for value in line] for line in image]
+
+
+def stretch(low, high):
+    return lambda i: min(255.0, max(0.0, (i - low) * 255.0 / (high - low))) if high > low else i
+
+
+# ----- HISTOGRAM MATCH --------------------------------------------------------------------------
+def match(image, reference_cdf):
+    source = cdf(histogram(image))
+    table = []
+    z = 0
+    for i in range(BINS):
+        while z < MAX_BIN and reference_cdf[z] + 1e-12 < source[i]:
+            z += 1
+        table.append(z)
+    return [[table[value] for value in line] for line in image]
+
+
+# ----- ADAPTIVE EQUALIZATION --------------------------------------------------------------------
+def tile_weights(length, grid):
+    tiles, weights = [], []
+    for i in range(length):
+        position = (i + 0.5) * grid / length - 0.5
+        index = max(0, min(grid - 1, int(math.floor(position))))
+        fraction = max(0.0, min(1.0, position - index))
+        tiles.append(index)
+        weights.append(0 if index == grid - 1 else int(c_round(fraction * 256)))
+    return tiles, weights
+
+
+def adaptive(image, grid_rows, grid_cols, clip_limit):
+    rows, cols = len(image), len(image[0])
+    grid_rows = max(1, min(grid_rows, rows))
+    grid_cols = max(1, min(grid_cols, cols))
+    lookups = []
+
+    for tile in range(grid_rows * grid_cols):
+        top = (tile // grid_cols) * rows // grid_rows
+        bottom = (tile // grid_cols + 1) * rows // grid_rows
+        left = (tile % grid_cols) * cols // grid_cols
+        right = (tile % grid_cols + 1) * cols // grid_cols
+
+        counts = [0] * BINS
+        for row in range(top, bottom):
+            for col in range(left, right):
+                counts[image[row][col]] += 1
+
+        pixels = max(1, (bottom - top) * (right - left))
+        limit = max(1, int(clip_limit * pixels / BINS))
+        excess = 0
+        for i in range(BINS):
+            if counts[i] > limit:
+                excess += counts[i] - limit
+                counts[i] = limit
+
+        share, residual = excess // BINS, excess % BINS
+        counts = [count + share for count in counts]
+        for i in range(residual):
+            counts[i * BINS // residual] += 1
+
+        lookup = []
+        running = 0
+        for count in counts:
+            running += count
+            lookup.append(min(MAX_BIN, (running * MAX_BIN + pixels // 2) // pixels))
+        lookups.append(lookup)
+
+    row_tile, row_weight = tile_weights(rows, grid_rows)
+    col_tile, col_weight = tile_weights(cols, grid_cols)
+    result = []
+
+    for row in range(rows):
+        upper_row = row_tile[row]
+        lower_row = upper_row + (1 if row_weight[row] else 0)
+        wy = row_weight[row]
+        line = []
+        for col in range(cols):
+            left_col = col_tile[col]
+            right_col = left_col + (1 if col_weight[col] else 0)
+            wx = col_weight[col]
+            value = image[row][col]
+
+            def at(tile_row, tile_col):
+                return lookups[tile_row * grid_cols + tile_col][value]
+
+            top = at(upper_row, left_col) * (256 - wx) + at(upper_row, right_col) * wx
+            bottom = at(lower_row, left_col) * (256 - wx) + at(lower_row, right_col) * wx
+            line.append((top * (256 - wy) + bottom * wy + (1 << 15)) >> 16)
+        result.append(line)
+    return result
+
+
+# ----- LOCAL EQUALIZATION -----------------------------------------------------------------------
+def local(image, radius):
+    # rank of every pixel within its clipped (2 radius + 1)^2 window
+    rows, cols = len(image), len(image[0])
+    result = []
+    for row in range(rows):
+        line = []
+        first_row, last_row = max(0, row - radius), min(rows - 1, row + radius)
+        for col in range(cols):
+            first_col, last_col = max(0, col - radius), min(cols - 1, col + radius)
+            value = image[row][col]
+            rank = sum(1 for r in range(first_row, last_row + 1)
+                       for c in range(first_col, last_col + 1) if image[r][c] <= value)
+            count = (last_row - first_row + 1) * (last_col - first_col + 1)
+            line.append((rank * MAX_BIN + count // 2) // count)
+        result.append(line)
+    return result
+
+
+# ----- OPERATIONS -------------------------------------------------------------------------------
+def operations(reference):
+    # the names and order of MyGolden::getOperations, values as MyOperation::toString writes them, the
+    # shortest text that reads back to the same double and no ".0" on whole numbers
+    def named(name, value=None):
+        if value is None:
+            return name
+        text = repr(float(value))
+        return "%s=%s" % (name, text[:-2] if text.endswith(".0") else text)
+
+    def equalize(image):
+        transform = equalization_transform(histogram(image))
+        return point(image, lambda i: float(transform[int(i)]))
+
+    def auto_contrast(percent):
+        def apply(image):
+            counts = histogram(image)
+            return point(image, stretch(percentile(counts, percent), percentile(counts, 100 - percent)))
+        return apply
+
+    reference_cdf = cdf(histogram(reference))
+    base = math.log(10 + 1)
+
+    return [
+        (named("positive"), lambda image: point(image, lambda i: i)),
+        (named("negative"), lambda image: point(image, lambda i: 255.0 - i)),
+        (named("shiftleft", 2), lambda image: point(image, lambda i: float(int(i) << 2))),
+        (named("shiftright", 2), lambda image: point(image, lambda i: float(int(i) >> 2))),
+        (named("scaleup", 1.5), lambda image: point(image, lambda i: i * 1.5)),
+        (named("scaledown", 2), lambda image: point(image, lambda i: i / 2.0)),
+        (named("exp"), lambda image: point(image, lambda i: math.exp(1.0 * i / 255.0))),
+        (named("ln"), lambda image: point(image, lambda i: math.log(1.0 + i))),
+        (named("power", 0.5), lambda image: point(image, lambda i: math.pow(i, 0.5))),
+        (named("power", 2.2), lambda image: point(image, lambda i: math.pow(i, 2.2))),
+        (named("log", 10), lambda image: point(image, lambda i: math.log(i + 1.0) / base)),
+        (named("equalize"), equalize),
+        (named("autocontrast", 0.5), auto_contrast(0.5)),
+        ("match", lambda image: match(image, reference_cdf)),
+        ("adaptive=8x8,4", lambda image: adaptive(image, 8, 8, 4)),
+        ("local=7", lambda image: local(image, 7)),
+    ]
+
+
+def output_name(sample, operation):
+    # MyGolden::getOutputPath
+    safe = "".join(c if c.isalnum() or c in "=.," else "_" for c in operation)
+    return sample.replace("/", "_") + "." + safe + ".png"
+
+
+def main():
+    golden = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    samples = os.path.join(golden, "samples")
+    os.makedirs(samples, exist_ok=True)
+
+    images = {"noise.pgm": make_noise(), "ramp.pgm": make_ramp(), "shapes.pgm": make_shapes()}
+    names = sorted(images)
+    for name in names:
+        write_pgm(os.path.join(samples, name), images[name])
+
+    # the first sample is the reference of the histogram match
+    lines = []
+    for name in names:
+        for operation, apply in operations(images[names[0]]):
+            result = apply(images[name])
+            write_png(os.path.join(golden, output_name(name, operation)), result)
+            lines.append("%s\t%s\t%s\n" % (name, operation, ",".join(str(c) for c in histogram(result))))
+
+    with open(os.path.join(golden, "golden.txt"), "w") as manifest:
+        manifest.writelines(lines)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "mybufferpool.h"
+#include "mydispatch.h"
+#include "mygolden.h"
+#include "myimage.h"
+#include "mymath.h"
+
+// ----- TIMING -----------------------------------------------------------------------------------
+template<class Function>
+static double measureRate(Function function, double megapixels)
+{
+    // best of several runs, in million pixels per second
+    double best = 0;
+    for(int run=0; run<5; run++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, megapixels / elapsed.count());
+    }
+    return best;
+}
+
+// ----- BENCHMARK --------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    MyBufferPool::install();
+
+    // imaging-basics-bench --golden-check <samples> <golden> [pixel tolerance, 0]
+    // imaging-basics-bench --golden-time-record <samples> <times file>
+    // imaging-basics-bench --golden-time-check <samples> <times file> [time tolerance, 1.5]
+    if(argc >= 4 && strcmp(argv[1], "--golden-check") == 0)
+    {
+        return MyGolden(argv[2], argv[3]).check(std::cout, argc > 4 ? atoi(argv[4]) : 0);
+    }
+    if(argc >= 4 && strcmp(argv[1], "--golden-time-record") == 0)
+    {
+        return MyGolden(argv[2], "").recordTimes(std::cout, argv[3]);
+    }
+    if(argc >= 4 && strcmp(argv[1], "--golden-time-check") == 0)
+    {
+        return MyGolden(argv[2], "").checkTimes(std::cout, argv[3], argc > 4 ? atof(argv[4]) : 1.5);
+    }
+
+    const int rows = 4096;
+    const int cols = 4096;
+    const double megapixels = rows * cols / 1e6;
+    const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
+
+    std::cout << "level " << MyDispatch::getLevelName(MyDispatch::getLevel())
+              << ", detected " << MyDispatch::getLevelName(MyDispatch::getDetectedLevel()) << std::endl;
+
+    MyImage inputImage("input");
+    MyImage outputImage("output");
+    inputImage.setImageToZero(rows, cols, MyImage::intensityColorMap);
+    cv::Mat pixels = inputImage.getRegion();
+    cv::randu(pixels, 0, 256);
+    inputImage.setIntensityHistograms();
+    outputImage.setImageMatchZero(inputImage);
+
+    std::vector<uint8_t> target(rows * cols);
+    std::vector<uint64_t> bins(MyImage::numberBins, 0);
+    uint8_t lookup[MyImage::numberBins];
+    for(int i=0; i<MyImage::numberBins; i++)
+    {
+        lookup[i] = MyImage::maxBin - i;
+    }
+
+    std::cout << "applyLookup      " << (int)measureRate([&]() { kernels.applyLookup(pixels.data, target.data(), rows * cols, lookup); }, megapixels) << " Mpix/s" << std::endl;
+    std::cout << "countHistogram   " << (int)measureRate([&]() { kernels.countHistogram(pixels.data, rows * cols, bins.data()); }, megapixels) << " Mpix/s" << std::endl;
+    std::cout << "processNegative  " << (int)measureRate([&]() { outputImage.processNegative(inputImage); }, megapixels) << " Mpix/s" << std::endl;
+    std::cout << "processPowerLaw  " << (int)measureRate([&]() { outputImage.processPowerLaw(inputImage, 0.5); }, megapixels) << " Mpix/s" << std::endl;
+    std::cout << "processEqualize  " << (int)measureRate([&]() { outputImage.processEqualize(inputImage); }, megapixels) << " Mpix/s" << std::endl;
+
+    // after the first run every operation should be served from the pool
+    MyBufferPool *pool = MyBufferPool::getInstance();
+    std::cout << "buffer pool      " << pool->getHits() << " hits, " << pool->getMisses() << " misses, "
+              << (pool->getBytesHeld() >> 20) << " MiB held" << std::endl;
+    std::cout << std::endl;
+
+    return MyMath::benchmark(std::cout);
+}
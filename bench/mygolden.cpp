@@ -0,0 +1,294 @@
+#include "mygolden.h"
+
+#include <chrono>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegExp>
+#include <QTextStream>
+
+#include "myoperation.h"
+
+static const double timeSlack = 0.5; // milliseconds, timer noise on the smallest samples
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyGolden::MyGolden(QString samplesDirectory, QString goldenDirectory) :
+    samples(samplesDirectory),
+    golden(goldenDirectory)
+{
+}
+
+MyGolden::~MyGolden()
+{
+    // destructor call goes here
+}
+
+// ----- MODES ------------------------------------------------------------------------------------
+int MyGolden::check(std::ostream &out, int pixelTolerance)
+{
+    QFile manifest(getManifestPath());
+    QStringList names = getSamples();
+
+    if(names.isEmpty() || !manifest.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        out << "no samples in " << samples.toStdString() << " or no " << getManifestPath().toStdString() << std::endl;
+        return 1;
+    }
+
+    // golden histograms by "sample operation"
+    QHash<QString, QStringList> expected = readLines(manifest);
+    MyImage reference("reference");
+    reference.setImageFromPath(QDir(samples).filePath(names[0]).toStdString());
+    QList<Operation> operations = getOperations(reference);
+    int checked = 0;
+    int failures = 0;
+
+    foreach (QString sample, names)
+    {
+        MyImage input("input");
+        input.setImageFromPath(QDir(samples).filePath(sample).toStdString());
+
+        foreach (Operation operation, operations)
+        {
+            QString label = sample + " " + operation.name;
+            QStringList fields = expected.value(label);
+            checked++;
+
+            if(fields.size() != 3)
+            {
+                out << "FAIL " << label.toStdString() << ": not recorded" << std::endl;
+                failures++;
+                continue;
+            }
+
+            Result result = runOperation(operation, input, 1);
+            cv::Mat goldenPixels = cv::imread(getOutputPath(sample, operation.name).toStdString(), cv::IMREAD_UNCHANGED);
+            QStringList counts = fields[2].split(",");
+            QStringList problems;
+
+            if(goldenPixels.empty() || goldenPixels.size() != result.pixels.size() || goldenPixels.type() != result.pixels.type())
+            {
+                problems.append("output size or type changed");
+            }
+            else
+            {
+                double difference = cv::norm(goldenPixels, result.pixels, cv::NORM_INF);
+                if(difference > pixelTolerance)
+                {
+                    problems.append("pixels differ by up to " + QString::number(difference));
+                }
+            }
+
+            bool sameHistogram = counts.size() == result.histogram.size();
+            for(int i=0; sameHistogram && i<counts.size(); i++)
+            {
+                sameHistogram = counts[i].toDouble() == result.histogram[i];
+            }
+            if(!sameHistogram)
+            {
+                problems.append("histogram differs");
+            }
+
+            if(!problems.isEmpty())
+            {
+                out << "FAIL " << label.toStdString() << ": " << problems.join(", ").toStdString() << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    out << checked - failures << " of " << checked << " passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int MyGolden::recordTimes(std::ostream &out, QString timesPath)
+{
+    QStringList names = getSamples();
+    QFile times(timesPath);
+
+    if(names.isEmpty() || !times.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        out << "no samples in " << samples.toStdString() << " or cannot write " << timesPath.toStdString() << std::endl;
+        return 1;
+    }
+
+    MyImage reference("reference");
+    reference.setImageFromPath(QDir(samples).filePath(names[0]).toStdString());
+    QList<Operation> operations = getOperations(reference);
+    QTextStream lines(&times);
+
+    foreach (QString sample, names)
+    {
+        MyImage input("input");
+        input.setImageFromPath(QDir(samples).filePath(sample).toStdString());
+
+        foreach (Operation operation, operations)
+        {
+            Result result = runOperation(operation, input, 3);
+            lines << sample << "\t" << operation.name << "\t" << result.milliseconds << "\n";
+        }
+        out << sample.toStdString() << " timed" << std::endl;
+    }
+    return 0;
+}
+
+int MyGolden::checkTimes(std::ostream &out, QString timesPath, double timeTolerance)
+{
+    QFile times(timesPath);
+    QStringList names = getSamples();
+
+    if(names.isEmpty() || !times.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        out << "no samples in " << samples.toStdString() << " or no " << timesPath.toStdString() << std::endl;
+        return 1;
+    }
+
+    QHash<QString, QStringList> expected = readLines(times);
+    MyImage reference("reference");
+    reference.setImageFromPath(QDir(samples).filePath(names[0]).toStdString());
+    QList<Operation> operations = getOperations(reference);
+    int checked = 0;
+    int failures = 0;
+
+    foreach (QString sample, names)
+    {
+        MyImage input("input");
+        input.setImageFromPath(QDir(samples).filePath(sample).toStdString());
+
+        foreach (Operation operation, operations)
+        {
+            QString label = sample + " " + operation.name;
+            QStringList fields = expected.value(label);
+            checked++;
+
+            if(fields.size() != 3)
+            {
+                out << "FAIL " << label.toStdString() << ": not timed" << std::endl;
+                failures++;
+                continue;
+            }
+
+            Result result = runOperation(operation, input, 3);
+            double budget = fields[2].toDouble() * timeTolerance + timeSlack;
+
+            if(result.milliseconds > budget)
+            {
+                out << "FAIL " << label.toStdString() << ": "
+                    << QString("took %1 ms, budget %2 ms").arg(result.milliseconds).arg(budget).toStdString() << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    out << checked - failures << " of " << checked << " within budget" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// ----- OPERATIONS -------------------------------------------------------------------------------
+QList<MyGolden::Operation> MyGolden::getOperations(MyImage &reference)
+{
+    QList<Operation> operations;
+    QList<MyOperation> tools = MyOperation::parseChain("positive,negative,shiftleft=2,shiftright=2,scaleup=1.5,"
+        "scaledown=2,exp,ln,power=0.5,power=2.2,log=10,equalize,autocontrast=0.5");
+
+    // every tool of the toolbox under its chain name, then the operations outside of it
+    foreach (MyOperation tool, tools)
+    {
+        Operation operation;
+        operation.name = tool.toString();
+        operation.apply = [tool](MyImage &output, MyImage &input) mutable { tool.processImage(output, input); };
+        operations.append(operation);
+    }
+
+    QVector<double> referenceCDF = reference.intensityCDF;
+    Operation match;
+    match.name = "match";
+    match.apply = [referenceCDF](MyImage &output, MyImage &input) { output.processHistogramMatch(input, referenceCDF); };
+    operations.append(match);
+
+    Operation adaptive;
+    adaptive.name = "adaptive=8x8,4";
+    adaptive.apply = [](MyImage &output, MyImage &input) { output.processAdaptiveEqualize(input, 8, 8, 4); };
+    operations.append(adaptive);
+
+    Operation local;
+    local.name = "local=7";
+    local.apply = [](MyImage &output, MyImage &input) { output.processLocalEqualize(input, 7); };
+    operations.append(local);
+
+    return operations;
+}
+
+QHash<QString, QStringList> MyGolden::readLines(QFile &file)
+{
+    // tab separated lines by "sample operation", the first two fields
+    QHash<QString, QStringList> lines;
+    QTextStream stream(&file);
+
+    while(!stream.atEnd())
+    {
+        QStringList fields = stream.readLine().split("\t");
+        if(fields.size() >= 2)
+        {
+            lines.insert(fields[0] + " " + fields[1], fields);
+        }
+    }
+    return lines;
+}
+
+QStringList MyGolden::getSamples()
+{
+    // relative paths, sorted so records and checks visit the samples in the same order
+    QStringList names;
+    QDir root(samples);
+    QDirIterator files(samples, QStringList() << "*.bmp" << "*.jpg" << "*.jpeg" << "*.pgm" << "*.png" << "*.tif",
+                       QDir::Files, QDirIterator::Subdirectories);
+
+    while(files.hasNext())
+    {
+        names.append(root.relativeFilePath(files.next()));
+    }
+    names.sort();
+    return names;
+}
+
+MyGolden::Result MyGolden::runOperation(Operation operation, MyImage &input, int runs)
+{
+    // best of the runs, every run starts from a fresh output like the toolbox does
+    Result result;
+    result.milliseconds = 0;
+
+    for(int run=0; run<runs; run++)
+    {
+        MyImage output("output");
+        output.setImageMatchZero(input);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        operation.apply(output, input);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if(run == 0 || elapsed.count() < result.milliseconds)
+        {
+            result.milliseconds = elapsed.count();
+        }
+        result.pixels = output.getRegion().clone();
+        result.histogram = output.intensityDistribution;
+    }
+    return result;
+}
+
+// ----- GOLDEN FILES -----------------------------------------------------------------------------
+QString MyGolden::getOutputPath(QString sample, QString operation)
+{
+    // "woman/woman.png" and "power=0.5" become "woman_woman.png.power=0.5.png"
+    QString name = sample.replace("/", "_") + "." + operation.replace(QRegExp("[^A-Za-z0-9=.,]"), "_") + ".png";
+    return QDir(golden).filePath(name);
+}
+
+QString MyGolden::getManifestPath()
+{
+    return QDir(golden).filePath("golden.txt");
+}
@@ -0,0 +1,67 @@
+#ifndef MYGOLDEN_H
+#define MYGOLDEN_H
+
+#include <functional>
+#include <iostream>
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "myimage.h"
+
+// ----- GOLDEN IMAGES -----
+// runs every MyImage::process* operation on each sample image below a directory and compares the
+// output pixels and histogram with stored golden results. bench/golden holds the samples, one
+// lossless PNG per sample and operation and golden.txt with one "sample operation counts" line
+// per result; they are written by bench/golden/make_golden.py from a plain reference of every
+// operation, never from the engine itself. a check fails when pixels differ by more than the
+// pixel tolerance or a histogram differs at all. time budgets are kept apart, in a file recorded
+// and checked on the same machine, and fail an operation slower than its recorded best of three
+// runs times the time tolerance
+class MyGolden
+{
+
+public:
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyGolden(QString samplesDirectory, QString goldenDirectory);
+    ~MyGolden();
+
+    // --- MODES ---
+    int check(std::ostream &out, int pixelTolerance);
+    int recordTimes(std::ostream &out, QString timesPath);
+    int checkTimes(std::ostream &out, QString timesPath, double timeTolerance);
+
+private:
+    // --- OPERATIONS ---
+    struct Operation
+    {
+        QString name;
+        std::function<void(MyImage &output, MyImage &input)> apply;
+    };
+
+    struct Result
+    {
+        cv::Mat pixels;
+        QVector<double> histogram;
+        double milliseconds;
+    };
+
+    QList<Operation> getOperations(MyImage &reference);
+    QStringList getSamples();
+    Result runOperation(Operation operation, MyImage &input, int runs);
+
+    // --- GOLDEN FILES ---
+    QString getOutputPath(QString sample, QString operation);
+    QString getManifestPath();
+    static QHash<QString, QStringList> readLines(QFile &file);
+
+    QString samples; // directory searched recursively for sample images
+    QString golden; // directory of the golden outputs and golden.txt, unused by the time modes
+
+};
+
+#endif // MYGOLDEN_H
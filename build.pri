@@ -0,0 +1,12 @@
+# shared compiler settings: CONFIG+=lto enables link time optimization and MARCH tunes code
+# generation, e.g. MARCH=native or MARCH=x86-64-v2 for a mixed farm; the pixel kernels pick
+# their instruction set at runtime either way, see MyDispatch
+
+CONFIG += c++11
+
+lto: CONFIG += ltcg
+
+!isEmpty(MARCH) {
+    win32-msvc*: QMAKE_CXXFLAGS += /arch:$$MARCH
+    else: QMAKE_CXXFLAGS += -march=$$MARCH
+}
@@ -0,0 +1,24 @@
+# CONFIG+=mycli_services adds the daemon and the watch mode, which need QtNetwork; the GUI
+# leaves them out and keeps the image, stream, match and statistics modes
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/mycli.cpp
+
+HEADERS += \
+    $$PWD/mycli.h
+
+mycli_services {
+    QT += network
+    DEFINES += MYCLI_SERVICES
+
+    SOURCES += \
+        $$PWD/mydaemon.cpp \
+        $$PWD/mywatcher.cpp
+
+    HEADERS += \
+        $$PWD/mydaemon.h \
+        $$PWD/mywatcher.h
+}
@@ -0,0 +1,16 @@
+# headless command line and processing daemon, links QtCore and QtGui for QImage and QtNetwork
+# for the daemon socket but no widgets
+
+QT = core gui
+CONFIG += mycli_services
+
+TARGET = imaging-basics-cli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../build.pri)
+include(../myimage/myimage-lib.pri)
+include(cli.pri)
+
+SOURCES += main.cpp
@@ -0,0 +1,11 @@
+#include "mybufferpool.h"
+#include "mycli.h"
+
+int main(int argc, char* argv[])
+{
+    MyBufferPool::install();
+
+    QCoreApplication MyApplication(argc, argv);
+    MyCli MyCommandLine;
+    return MyCommandLine.run(MyApplication.arguments());
+}
@@ -0,0 +1,463 @@
+#include "mycli.h"
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyCli::MyCli() :
+    csvHeaderWritten(false),
+    cache(0)
+{
+}
+
+MyCli::~MyCli()
+{
+    delete cache;
+}
+
+// ----- ENTRY POINT ------------------------------------------------------------------------------
+bool MyCli::isCommandLine(int argc, char *argv[])
+{
+    // only the options of the command line select headless mode, Qt options such as --platform or
+    // -style are left to QApplication
+    QStringList names = QStringList() << "ops" << "stream" << "match" << "output-dir" << "bench-math"
+        << "cache" << "cache-size" << "csv" << "help";
+#ifdef MYCLI_SERVICES
+    names << "daemon" << "threads" << "submit" << "stats" << "shutdown" << "watch" << "queue" << "settle";
+#endif
+
+    for(int i=1; i<argc; i++)
+    {
+        QString argument(argv[i]);
+
+        if(argument == "--")
+        {
+            break;
+        }
+        if(argument == "-h" || argument == "-?" ||
+           (argument.startsWith("--") && names.contains(argument.mid(2).section('=', 0, 0))))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int MyCli::run(QStringList arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless intensity transforms, e.g. --ops negative,power=0.5 in.png out.png");
+    parser.addHelpOption();
+
+    QCommandLineOption opsOption("ops", "Comma separated operation chain: positive, negative, shiftleft=N, "
+        "shiftright=N, scaleup=F, scaledown=F, exp, ln, power=G, log=B, equalize, autocontrast=P with P below 50.", "chain");
+    QCommandLineOption streamOption("stream", "Process PGM or TIFF files in strips without loading the whole image.");
+    QCommandLineOption matchOption("match", "Match the histogram of every input to the reference image.", "reference");
+    QCommandLineOption outputDirOption("output-dir", "Write one output per input into this directory.", "directory");
+    QCommandLineOption benchMathOption("bench-math", "Compare the vector exp, log and pow kernels against libm.");
+    QCommandLineOption cacheOption("cache", "Keep results in this directory and copy them from there when the same "
+        "unchanged input is processed with the same chain again.", "directory");
+    QCommandLineOption csvOption("csv", "Append histogram statistics of every output image to this CSV file, "
+        "- for standard output; without --ops the inputs themselves are summarized.", "file");
+    QCommandLineOption cacheSizeOption("cache-size", "Megabytes the cache directory may hold before the least "
+        "recently used results are removed, 1024 by default.", "MiB", "1024");
+
+    parser.addOption(opsOption);
+    parser.addOption(streamOption);
+    parser.addOption(matchOption);
+    parser.addOption(outputDirOption);
+    parser.addOption(benchMathOption);
+    parser.addOption(cacheOption);
+    parser.addOption(cacheSizeOption);
+    parser.addOption(csvOption);
+#ifdef MYCLI_SERVICES
+    addServiceOptions(parser);
+#endif
+    parser.addPositionalArgument("input", "Source image.");
+    parser.addPositionalArgument("output", "Destination image, omitted with --output-dir.");
+    parser.process(arguments);
+
+    QStringList files = parser.positionalArguments();
+    csvPath = parser.value(csvOption);
+
+    if(parser.isSet(cacheOption))
+    {
+        cache = new MyResultCache(parser.value(cacheOption), parser.value(cacheSizeOption).toLongLong() << 20);
+    }
+
+    if(parser.isSet(benchMathOption))
+    {
+        return MyMath::benchmark(std::cout);
+    }
+
+#ifdef MYCLI_SERVICES
+    int result = 0;
+    if(runServices(parser, result))
+    {
+        return result;
+    }
+#endif
+
+    if(parser.isSet(matchOption))
+    {
+        return runMatch(parser.value(matchOption), files, parser.value(outputDirOption));
+    }
+
+    if(parser.isSet(csvOption) && !parser.isSet(opsOption))
+    {
+        return runStatistics(files);
+    }
+
+    bool ok = false;
+    QList<MyOperation> operations = MyOperation::parseChain(parser.value(opsOption), &ok);
+
+    if(!ok || files.size() != 2)
+    {
+        std::cerr << parser.helpText().toStdString();
+        return 1;
+    }
+
+    if(parser.isSet(streamOption))
+    {
+        return runStream(operations, files[0], files[1]);
+    }
+    return runImage(operations, files[0], files[1]);
+}
+
+// ----- MODES ------------------------------------------------------------------------------------
+int MyCli::runImage(QList<MyOperation> operations, QString inputPath, QString outputPath)
+{
+    QByteArray key;
+    if(cache)
+    {
+        key = MyResultCache::keyForFile(inputPath, operations, outputPath);
+        QVector<double> histogram;
+
+        if(cache->fetch(key, outputPath, &histogram))
+        {
+            MyStatistics statistics(histogram);
+            if(!csvPath.isEmpty() && statistics.count == 0)
+            {
+                // wide outputs are cached without a histogram, the result is read back instead
+                MyImage cached("output");
+                cached.setImageFromPath(outputPath.toStdString());
+                statistics = cached.getStatistics();
+            }
+            writeStatistics(outputPath, statistics);
+            return 0;
+        }
+    }
+
+    MyImage inputImage("input");
+    MyImage outputImage("output");
+
+    inputImage.setImageFromPath(inputPath.toStdString());
+    if(inputImage.getSize() == 0)
+    {
+        std::cerr << "cannot read " << inputPath.toStdString() << std::endl;
+        return 1;
+    }
+
+    outputImage.setImageMatchZero(inputImage);
+    operations[0].processImage(outputImage, inputImage);
+
+    for(int i=1; i<operations.size(); i++)
+    {
+        operations[i].processImage(outputImage, outputImage);
+    }
+
+    if(!outputImage.saveImageToPath(outputPath))
+    {
+        std::cerr << "cannot write " << outputPath.toStdString() << std::endl;
+        return 1;
+    }
+
+    if(cache)
+    {
+        cache->store(key, outputPath, outputImage.intensityDistribution);
+    }
+    writeStatistics(outputPath, outputImage.getStatistics());
+    return 0;
+}
+
+int MyCli::runMatch(QString referencePath, QStringList files, QString outputDirectory)
+{
+    // the reference CDF is built once and reused for every input of the batch
+    MyImage referenceImage("reference");
+    referenceImage.setImageFromPath(referencePath.toStdString());
+
+    if(referenceImage.getSize() == 0)
+    {
+        std::cerr << "cannot read " << referencePath.toStdString() << std::endl;
+        return 1;
+    }
+
+    QVector<double> referenceCDF = referenceImage.intensityCDF;
+    QStringList inputs;
+    QStringList outputs;
+
+    if(outputDirectory.isEmpty())
+    {
+        if(files.size() != 2)
+        {
+            std::cerr << "expected an input and an output, or --output-dir" << std::endl;
+            return 1;
+        }
+        inputs.append(files[0]);
+        outputs.append(files[1]);
+    }
+    else
+    {
+        QDir directory(outputDirectory);
+        foreach (QString file, files)
+        {
+            inputs.append(file);
+            outputs.append(directory.filePath(QFileInfo(file).fileName()));
+        }
+    }
+
+    int failures = 0;
+    for(int i=0; i<inputs.size(); i++)
+    {
+        MyImage inputImage("input");
+        MyImage outputImage("output");
+
+        inputImage.setImageFromPath(inputs[i].toStdString());
+        if(inputImage.getSize() == 0)
+        {
+            std::cerr << "cannot read " << inputs[i].toStdString() << std::endl;
+            failures++;
+            continue;
+        }
+
+        outputImage.setImageMatchZero(inputImage);
+        if(!outputImage.processHistogramMatch(inputImage, referenceCDF))
+        {
+            std::cerr << "histogram matching needs an 8 bit image: " << inputs[i].toStdString() << std::endl;
+            failures++;
+            continue;
+        }
+
+        if(!outputImage.saveImageToPath(outputs[i]))
+        {
+            std::cerr << "cannot write " << outputs[i].toStdString() << std::endl;
+            failures++;
+            continue;
+        }
+        writeStatistics(outputs[i], outputImage.getStatistics());
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int MyCli::runStream(QList<MyOperation> operations, QString inputPath, QString outputPath)
+{
+    MyStream stream;
+
+    if(!stream.process(inputPath, outputPath, operations))
+    {
+        std::cerr << stream.getError().toStdString() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int MyCli::runStatistics(QStringList files)
+{
+    int failures = 0;
+
+    foreach (QString file, files)
+    {
+        MyImage image("input");
+        image.setImageFromPath(file.toStdString());
+
+        if(image.getSize() == 0)
+        {
+            std::cerr << "cannot read " << file.toStdString() << std::endl;
+            failures++;
+            continue;
+        }
+        writeStatistics(file, image.getStatistics());
+    }
+    return failures == 0 && !files.isEmpty() ? 0 : 1;
+}
+
+// ----- STATISTICS CSV ---------------------------------------------------------------------------
+void MyCli::writeStatistics(QString imagePath, MyStatistics statistics)
+{
+    if(csvPath.isEmpty())
+    {
+        return;
+    }
+
+    QFile file;
+    if(csvPath == "-")
+    {
+        file.open(stdout, QIODevice::WriteOnly);
+    }
+    else
+    {
+        file.setFileName(csvPath);
+        file.open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+
+    if(!file.isOpen())
+    {
+        std::cerr << "cannot write " << csvPath.toStdString() << std::endl;
+        csvPath.clear();
+        return;
+    }
+
+    // a header for a new file, appending runs share the one they found
+    if(!csvHeaderWritten && (csvPath == "-" || file.size() == 0))
+    {
+        file.write("image,pixels,min,max,mean,variance,sd,median,p1,p5,p25,p75,p95,p99,entropy,dynamic_range\n");
+    }
+    csvHeaderWritten = true;
+
+    QStringList fields;
+    fields << "\"" + QString(imagePath).replace("\"", "\"\"") + "\"";
+    fields << QString::number(statistics.count, 'f', 0) << QString::number(statistics.minimum)
+           << QString::number(statistics.maximum) << QString::number(statistics.mean, 'g', 10)
+           << QString::number(statistics.variance, 'g', 10) << QString::number(statistics.standardDeviation, 'g', 10)
+           << QString::number(statistics.median);
+
+    double percents[] = { 1, 5, 25, 75, 95, 99 };
+    for(int i=0; i<6; i++)
+    {
+        fields << QString::number(statistics.getPercentile(percents[i]));
+    }
+    fields << QString::number(statistics.entropy, 'g', 10) << QString::number(statistics.dynamicRange);
+
+    file.write((fields.join(",") + "\n").toUtf8());
+}
+
+// ----- SERVICES ---------------------------------------------------------------------------------
+#ifdef MYCLI_SERVICES
+void MyCli::addServiceOptions(QCommandLineParser &parser)
+{
+    parser.addOption(QCommandLineOption("daemon", "Serve jobs on a local socket until a shutdown request.", "socket"));
+    parser.addOption(QCommandLineOption("threads", "Worker threads of the daemon or watch mode, one per core by default.", "count"));
+    parser.addOption(QCommandLineOption("submit", "Send the job to the daemon on this socket and print its reply.", "socket"));
+    parser.addOption(QCommandLineOption("stats", "With --submit, ask the daemon for its job and latency statistics."));
+    parser.addOption(QCommandLineOption("shutdown", "With --submit, stop the daemon."));
+    parser.addOption(QCommandLineOption("watch", "Process every image written into this directory, "
+        "results go to --output-dir.", "directory"));
+    parser.addOption(QCommandLineOption("queue", "Files the watch mode holds at once before it stops taking new ones, "
+        "64 by default.", "count", "64"));
+    parser.addOption(QCommandLineOption("settle", "Milliseconds a watched file must stay unchanged before it is "
+        "processed, 250 by default.", "ms", "250"));
+}
+
+bool MyCli::runServices(QCommandLineParser &parser, int &result)
+{
+    // the modes that keep running or talk to one that does, false when none of them is selected
+    QStringList files = parser.positionalArguments();
+    int threads = parser.value("threads").toInt();
+
+    if(parser.isSet("daemon"))
+    {
+        result = runDaemon(parser.value("daemon"), threads);
+        return true;
+    }
+
+    if(parser.isSet("submit") && (parser.isSet("stats") || parser.isSet("shutdown")))
+    {
+        QJsonObject request;
+        request[parser.isSet("stats") ? "stats" : "shutdown"] = true;
+        result = runSubmit(parser.value("submit"), request);
+        return true;
+    }
+
+    if(parser.isSet("match") || (parser.isSet("csv") && !parser.isSet("ops")))
+    {
+        return false;
+    }
+
+    bool ok = false;
+    QList<MyOperation> operations = MyOperation::parseChain(parser.value("ops"), &ok);
+
+    if(ok && parser.isSet("watch") && parser.isSet("output-dir"))
+    {
+        result = runWatch(operations, parser.value("watch"), parser.value("output-dir"), threads,
+                          parser.value("queue").toInt(), parser.value("settle").toInt());
+        return true;
+    }
+
+    if(ok && parser.isSet("submit") && files.size() == 2)
+    {
+        // the daemon runs in its own working directory
+        QJsonObject request;
+        request["id"] = 1;
+        request["ops"] = MyOperation::toChain(operations);
+        request["input"] = QFileInfo(files[0]).absoluteFilePath();
+        request["output"] = QFileInfo(files[1]).absoluteFilePath();
+        result = runSubmit(parser.value("submit"), request);
+        return true;
+    }
+    return false;
+}
+
+int MyCli::runDaemon(QString serverName, int threads)
+{
+    MyDaemon daemon;
+    daemon.setCache(cache);
+
+    if(!daemon.listen(serverName, threads))
+    {
+        std::cerr << "cannot listen on " << serverName.toStdString() << ": " << daemon.getError().toStdString() << std::endl;
+        return 1;
+    }
+    std::cerr << "listening on " << serverName.toStdString() << std::endl;
+
+    int result = QCoreApplication::exec();
+    std::cerr << QJsonDocument(daemon.getStats()).toJson(QJsonDocument::Compact).toStdString() << std::endl;
+    return result;
+}
+
+int MyCli::runSubmit(QString serverName, QJsonObject request)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+
+    if(!socket.waitForConnected(5000))
+    {
+        std::cerr << "cannot connect to " << serverName.toStdString() << ": " << socket.errorString().toStdString() << std::endl;
+        return 1;
+    }
+
+    socket.write(MyDaemon::frame(request));
+    socket.waitForBytesWritten(-1);
+
+    QByteArray buffer;
+    QJsonObject reply;
+    int status = 0;
+
+    while((status = MyDaemon::unframe(buffer, reply)) == 0)
+    {
+        if(!socket.waitForReadyRead(-1))
+        {
+            std::cerr << "connection closed by " << serverName.toStdString() << std::endl;
+            return 1;
+        }
+        buffer.append(socket.readAll());
+    }
+
+    std::cout << QJsonDocument(reply).toJson(QJsonDocument::Compact).toStdString() << std::endl;
+    return status == 1 && reply.value("ok").toBool() ? 0 : 1;
+}
+
+int MyCli::runWatch(QList<MyOperation> operations, QString spoolDirectory, QString outputDirectory,
+                    int threads, int queueSize, int settleMs)
+{
+    MyWatcher watcher;
+    watcher.setCache(cache);
+
+    if(!watcher.watch(spoolDirectory, outputDirectory, operations, threads, queueSize, settleMs))
+    {
+        std::cerr << watcher.getError().toStdString() << std::endl;
+        return 1;
+    }
+    std::cerr << "watching " << spoolDirectory.toStdString() << std::endl;
+
+    int result = QCoreApplication::exec();
+    std::cerr << watcher.getProcessed() << " processed, " << watcher.getFailed() << " failed" << std::endl;
+    return result;
+}
+#endif
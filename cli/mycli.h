@@ -0,0 +1,65 @@
+#ifndef MYCLI_H
+#define MYCLI_H
+
+#include <iostream>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+#include "myimage.h"
+#include "mymath.h"
+#include "myoperation.h"
+#include "myresultcache.h"
+#include "mystatistics.h"
+#include "mystream.h"
+
+#ifdef MYCLI_SERVICES
+#include "mydaemon.h"
+#include "mywatcher.h"
+#endif
+
+class MyCli
+{
+
+public:
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyCli();
+    ~MyCli();
+
+    // --- ENTRY POINT ---
+    static bool isCommandLine(int argc, char *argv[]);
+    int run(QStringList arguments);
+
+private:
+    // --- MODES ---
+    int runImage(QList<MyOperation> operations, QString inputPath, QString outputPath);
+    int runStream(QList<MyOperation> operations, QString inputPath, QString outputPath);
+    int runMatch(QString referencePath, QStringList files, QString outputDirectory);
+    int runStatistics(QStringList files);
+
+#ifdef MYCLI_SERVICES
+    // --- SERVICES ---
+    void addServiceOptions(QCommandLineParser &parser);
+    bool runServices(QCommandLineParser &parser, int &result);
+    int runDaemon(QString serverName, int threads);
+    int runSubmit(QString serverName, QJsonObject request);
+    int runWatch(QList<MyOperation> operations, QString spoolDirectory, QString outputDirectory,
+                 int threads, int queueSize, int settleMs);
+#endif
+
+    // --- STATISTICS CSV ---
+    QString csvPath; // empty without --csv, "-" for standard output
+    bool csvHeaderWritten;
+    void writeStatistics(QString imagePath, MyStatistics statistics);
+
+    // --- RESULT CACHE ---
+    MyResultCache *cache; // 0 without --cache
+
+};
+
+#endif // MYCLI_H
@@ -0,0 +1,468 @@
+#include "mydaemon.h"
+
+#include <iostream>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+
+#include "mydispatch.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// ----- JOBS -------------------------------------------------------------------------------------
+MyDaemonJob::MyDaemonJob(QObject *daemon, MyResultCache *results, quint64 client, QJsonObject request) :
+    owner(daemon),
+    cache(results),
+    clientId(client),
+    job(request)
+{
+    queued.start();
+}
+
+void MyDaemonJob::run()
+{
+    double queueMs = queued.nsecsElapsed() / 1e6;
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok = false;
+    QList<MyOperation> operations = MyOperation::parseChain(job.value("ops").toString(), &ok);
+    QString failure = "invalid operation chain";
+    bool cached = false;
+
+    try
+    {
+        if(ok && job.contains("buffer"))
+        {
+            failure = checkFile(job.value("buffer").toString(), true, true);
+            failure = failure.isEmpty() ? processBuffer(operations) : failure;
+        }
+        else if(ok)
+        {
+            QString inputPath = job.value("input").toString();
+            QString outputPath = job.value("output").toString();
+
+            failure = checkFile(inputPath, false, true);
+            failure = failure.isEmpty() ? checkFile(outputPath, true, false) : failure;
+            failure = failure.isEmpty() ? processFile(operations, inputPath, outputPath, cache, &cached) : failure;
+        }
+    }
+    catch(const std::exception &exception)
+    {
+        // an exception escaping a pool thread would take the whole daemon down
+        failure = exception.what();
+    }
+
+    QJsonObject reply;
+    reply["id"] = job.value("id");
+    reply["ok"] = failure.isEmpty();
+    reply["queueMs"] = queueMs;
+    reply["processMs"] = timer.nsecsElapsed() / 1e6;
+    reply["cached"] = cached;
+    if(!failure.isEmpty())
+    {
+        reply["error"] = failure;
+    }
+
+    QMetaObject::invokeMethod(owner, "finishJob", Qt::QueuedConnection, Q_ARG(quint64, clientId), Q_ARG(QJsonObject, reply));
+}
+
+QString MyDaemonJob::checkFile(QString path, bool writable, bool existing)
+{
+    // the daemon holds the rights of its owner, so a job may only name what that user could open
+    // directly; devices, pipes and sockets are refused as well as relative paths
+    QFileInfo info(path);
+
+    if(path.isEmpty() || info.isRelative())
+    {
+        return "not an absolute path: " + path;
+    }
+
+    if(!info.exists())
+    {
+        QFileInfo directory(info.absolutePath());
+        if(existing || !directory.isDir() || !directory.isWritable())
+        {
+            return "cannot access " + path;
+        }
+        return "";
+    }
+
+    if(!info.isFile() || !info.isReadable() || (writable && !info.isWritable()))
+    {
+        return "not a regular file the client can access: " + path;
+    }
+    return "";
+}
+
+QString MyDaemonJob::processFile(QList<MyOperation> operations, QString inputPath, QString outputPath,
+                                 MyResultCache *cache, bool *cached)
+{
+    QByteArray key;
+    if(cache)
+    {
+        key = MyResultCache::keyForFile(inputPath, operations, outputPath);
+        if(cache->fetch(key, outputPath))
+        {
+            if(cached)
+            {
+                *cached = true;
+            }
+            return "";
+        }
+    }
+
+    // one buffer for the whole chain, every step runs in place
+    MyImage image("daemon");
+
+    image.setImageFromPath(inputPath.toStdString());
+    if(image.getSize() == 0)
+    {
+        return "cannot read " + inputPath;
+    }
+
+    for(int i=0; i<operations.size(); i++)
+    {
+        operations[i].processImage(image, image);
+    }
+
+    if(!image.saveImageToPath(outputPath))
+    {
+        return "cannot write " + outputPath;
+    }
+
+    if(cache)
+    {
+        cache->store(key, outputPath, image.intensityDistribution);
+    }
+    return "";
+}
+
+QString MyDaemonJob::processBuffer(QList<MyOperation> operations)
+{
+    // the caller shares the pixels through a file, /dev/shm keeps it in memory, and the chain
+    // is applied in place on the mapping without a copy
+    QString format = job.value("format").toString("u8");
+    int rows = job.value("rows").toInt();
+    int cols = job.value("cols").toInt();
+    qint64 stride = job.value("stride").toVariant().toLongLong();
+    qint64 offset = job.value("offset").toVariant().toLongLong();
+
+    int type = format == "u8" ? CV_8UC1 : format == "u16" ? CV_16UC1 : format == "f32" ? CV_32FC1 : -1;
+    if(type < 0)
+    {
+        return "unknown format " + format;
+    }
+    if(type != CV_8UC1 && MyOperation::needsDistribution(operations))
+    {
+        return "equalization and auto contrast need u8 pixels";
+    }
+
+    qint64 pixelSize = CV_ELEM_SIZE(type);
+    if(rows <= 0 || cols <= 0 || offset < 0 || stride < cols * pixelSize || stride % pixelSize != 0)
+    {
+        return "invalid buffer layout";
+    }
+
+    // stride is positive here, dividing keeps a huge offset or stride from overflowing the test
+    QFile file(job.value("buffer").toString());
+    if(!file.open(QIODevice::ReadWrite) || offset > file.size() || rows > (file.size() - offset) / stride)
+    {
+        return "cannot map " + file.fileName();
+    }
+
+    uchar *pixels = file.map(offset, stride * rows);
+    if(!pixels)
+    {
+        return "cannot map " + file.fileName();
+    }
+
+    MyImage image("daemon");
+    image.setImageFromMatrix(cv::Mat(rows, cols, type, pixels, stride));
+
+    for(int i=0; i<operations.size(); i++)
+    {
+        operations[i].processImage(image, image);
+    }
+
+    file.unmap(pixels);
+    return "";
+}
+
+// ----- WARM UP ----------------------------------------------------------------------------------
+class MyWarmUpJob : public QRunnable
+{
+public:
+    void run()
+    {
+        // binds the kernels and touches the engine once on every pool thread
+        MyImage engine("warm-up");
+        engine.setImageToZero(64, 64, MyImage::intensityColorMap);
+        MyOperation(MyOperation::Equalize).processImage(engine, engine);
+    }
+};
+
+// ----- FRAMING ----------------------------------------------------------------------------------
+QByteArray MyDaemon::frame(QJsonObject message)
+{
+    QByteArray payload = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    QByteArray header(4, '\0');
+    qToBigEndian<quint32>(payload.size(), (uchar *)header.data());
+    return header + payload;
+}
+
+int MyDaemon::unframe(QByteArray &buffer, QJsonObject &message)
+{
+    if(buffer.size() < 4)
+    {
+        return 0;
+    }
+
+    quint32 size = qFromBigEndian<quint32>((const uchar *)buffer.constData());
+    if(size > (quint32)maxFrameSize)
+    {
+        return -1;
+    }
+    if((quint32)buffer.size() < 4 + size)
+    {
+        return 0;
+    }
+
+    QJsonParseError parse;
+    QJsonDocument document = QJsonDocument::fromJson(buffer.mid(4, size), &parse);
+    buffer.remove(0, 4 + size);
+
+    if(parse.error != QJsonParseError::NoError || !document.isObject())
+    {
+        return -1;
+    }
+    message = document.object();
+    return 1;
+}
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyDaemon::MyDaemon(QObject *parent) :
+    QObject(parent),
+    cache(0),
+    nextClient(1),
+    jobsDone(0),
+    jobsFailed(0),
+    latencyCursor(0)
+{
+    connect(&server, SIGNAL(newConnection()), this, SLOT(acceptClient()));
+}
+
+MyDaemon::~MyDaemon()
+{
+    server.close();
+    pool.waitForDone();
+}
+
+// ----- SERVER -----------------------------------------------------------------------------------
+bool MyDaemon::listen(QString name, int threads)
+{
+    // a second daemon on the same name keeps its socket, only a socket file nobody answers on is
+    // left over from a daemon that did not shut down cleanly and is removed
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if(probe.waitForConnected(1000))
+    {
+        probe.abort();
+        error = "another daemon is listening on " + name;
+        return false;
+    }
+    if(probe.error() == QLocalSocket::ConnectionRefusedError)
+    {
+        QLocalServer::removeServer(name);
+    }
+
+    // the socket is created for the owning user only, other local users cannot connect
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+
+    if(!server.listen(name))
+    {
+        error = server.errorString();
+        return false;
+    }
+
+    pool.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+    pool.setExpiryTimeout(-1);
+    warmUp();
+    uptime.start();
+    return true;
+}
+
+void MyDaemon::setCache(MyResultCache *results)
+{
+    cache = results;
+}
+
+QString MyDaemon::getError()
+{
+    return error;
+}
+
+void MyDaemon::warmUp()
+{
+    MyDispatch::getKernels();
+
+    // not waited for, waitForDone would also retire the threads that were just started
+    for(int i=0; i<pool.maxThreadCount(); i++)
+    {
+        pool.start(new MyWarmUpJob());
+    }
+}
+
+void MyDaemon::acceptClient()
+{
+    while(server.hasPendingConnections())
+    {
+        QLocalSocket *socket = server.nextPendingConnection();
+
+#ifdef Q_OS_LINUX
+        // the socket rights already keep other users out, the peer credentials make sure of it
+        struct ucred peer;
+        socklen_t length = sizeof(peer);
+        if(getsockopt(socket->socketDescriptor(), SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0 ||
+           peer.uid != geteuid())
+        {
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+#endif
+
+        quint64 client = nextClient++;
+
+        socket->setProperty("client", client);
+        clients.insert(client, socket);
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readClient()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(dropClient()));
+    }
+}
+
+void MyDaemon::readClient()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    quint64 client = socket->property("client").toULongLong();
+    QByteArray &buffer = pending[client];
+    QJsonObject message;
+    int status = 0;
+
+    buffer.append(socket->readAll());
+
+    while((status = unframe(buffer, message)) == 1)
+    {
+        if(message.value("stats").toBool())
+        {
+            reply(client, getStats());
+        }
+        else if(message.value("shutdown").toBool())
+        {
+            QJsonObject done;
+            done["ok"] = true;
+            reply(client, done);
+            socket->flush();
+            QTimer::singleShot(0, QCoreApplication::instance(), SLOT(quit()));
+        }
+        else
+        {
+            pool.start(new MyDaemonJob(this, cache, client, message));
+        }
+    }
+
+    if(status < 0)
+    {
+        // the stream cannot be resynchronized after a bad frame
+        QJsonObject invalid;
+        invalid["ok"] = false;
+        invalid["error"] = "invalid frame";
+        reply(client, invalid);
+        socket->disconnectFromServer();
+    }
+}
+
+void MyDaemon::dropClient()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    quint64 client = socket->property("client").toULongLong();
+
+    // jobs of this client still finish, their replies are dropped in finishJob
+    clients.remove(client);
+    pending.remove(client);
+    socket->deleteLater();
+}
+
+void MyDaemon::finishJob(quint64 client, QJsonObject result)
+{
+    bool ok = result.value("ok").toBool();
+    double latency = result.value("queueMs").toDouble() + result.value("processMs").toDouble();
+    recordLatency(latency, ok);
+
+    std::cerr << "job " << result.value("id").toVariant().toString().toStdString() << (ok ? " done" : " failed")
+              << " in " << latency << " ms" << std::endl;
+    reply(client, result);
+}
+
+void MyDaemon::reply(quint64 client, QJsonObject message)
+{
+    QLocalSocket *socket = clients.value(client);
+    if(socket)
+    {
+        socket->write(frame(message));
+    }
+}
+
+// ----- STATISTICS -------------------------------------------------------------------------------
+void MyDaemon::recordLatency(double milliseconds, bool ok)
+{
+    jobsDone++;
+    jobsFailed += ok ? 0 : 1;
+
+    if(latencies.size() < latencyWindow)
+    {
+        latencies.append(milliseconds);
+        return;
+    }
+    latencies[latencyCursor] = milliseconds;
+    latencyCursor = (latencyCursor + 1) % latencyWindow;
+}
+
+QJsonObject MyDaemon::getStats()
+{
+    std::vector<double> sorted(latencies.begin(), latencies.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    QJsonObject stats;
+    stats["ok"] = true;
+    stats["jobs"] = (double)jobsDone;
+    stats["failed"] = (double)jobsFailed;
+    stats["running"] = pool.activeThreadCount();
+    stats["threads"] = pool.maxThreadCount();
+    stats["uptimeSeconds"] = uptime.elapsed() / 1000.0;
+
+    if(!sorted.empty())
+    {
+        // nearest rank percentiles over the latency window, queue wait plus processing
+        stats["p50Ms"] = sorted[(sorted.size() - 1) * 50 / 100];
+        stats["p95Ms"] = sorted[(sorted.size() - 1) * 95 / 100];
+        stats["p99Ms"] = sorted[(sorted.size() - 1) * 99 / 100];
+        stats["maxMs"] = sorted.back();
+    }
+
+    if(cache)
+    {
+        stats["cacheHits"] = (double)cache->getHits();
+        stats["cacheMisses"] = (double)cache->getMisses();
+        stats["cacheBytes"] = (double)cache->getBytesHeld();
+    }
+    return stats;
+}
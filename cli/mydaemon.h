@@ -0,0 +1,107 @@
+#ifndef MYDAEMON_H
+#define MYDAEMON_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+
+#include "myimage.h"
+#include "myoperation.h"
+#include "myresultcache.h"
+
+// ----- PROCESSING DAEMON -----
+// keeps the engine, its kernels and a thread pool warm behind a local socket (a Unix domain
+// socket, a named pipe on Windows). every frame is a 4 byte big endian length followed by that
+// many bytes of UTF-8 JSON, in both directions:
+//
+//   {"id": 1, "ops": "negative,equalize", "input": "/abs/in.png", "output": "/abs/out.png"}
+//   {"id": 2, "ops": "power=0.5", "buffer": "/dev/shm/frame", "offset": 0, "rows": 480,
+//    "cols": 640, "stride": 640, "format": "u8"}    processed in place, also "u16" and "f32"
+//   {"stats": true}    {"shutdown": true}
+//
+// jobs run concurrently, so replies can arrive out of order and carry the id of their request:
+//   {"id": 1, "ok": true, "queueMs": 0.02, "processMs": 11.7, "cached": false}
+//
+// only the user running the daemon can connect, and every path has to be absolute and name a
+// regular file that user can already read, or write for outputs and buffers
+class MyDaemonJob : public QRunnable
+{
+
+public:
+    MyDaemonJob(QObject *daemon, MyResultCache *results, quint64 client, QJsonObject request);
+    void run();
+
+    // runs the chain in place on one frame buffer, an empty string on success; with a cache an
+    // unchanged input with the same chain is copied from it without decoding
+    static QString processFile(QList<MyOperation> operations, QString inputPath, QString outputPath,
+                               MyResultCache *cache = 0, bool *cached = 0);
+
+private:
+    QString processBuffer(QList<MyOperation> operations);
+    static QString checkFile(QString path, bool writable, bool existing);
+
+    QObject *owner; // receives the reply through a queued call of finishJob
+    MyResultCache *cache; // 0 without --cache
+    quint64 clientId;
+    QJsonObject job;
+    QElapsedTimer queued;
+};
+
+class MyDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    // --- FRAMING ---
+    static const int maxFrameSize = 1 << 20;
+    static QByteArray frame(QJsonObject message);
+    static int unframe(QByteArray &buffer, QJsonObject &message); // 1 message, 0 incomplete, -1 invalid
+
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    explicit MyDaemon(QObject *parent = 0);
+    ~MyDaemon();
+
+    // --- SERVER ---
+    bool listen(QString name, int threads);
+    void setCache(MyResultCache *results);
+    QString getError();
+    QJsonObject getStats();
+
+private slots:
+    void acceptClient();
+    void readClient();
+    void dropClient();
+    void finishJob(quint64 client, QJsonObject reply);
+
+private:
+    void warmUp();
+    void reply(quint64 client, QJsonObject message);
+    void recordLatency(double milliseconds, bool ok);
+
+    // --- SERVER STATE ---
+    QLocalServer server;
+    QThreadPool pool;
+    MyResultCache *cache;
+    QHash<quint64, QLocalSocket *> clients;
+    QHash<quint64, QByteArray> pending; // bytes of a frame that is not complete yet
+    quint64 nextClient;
+    QString error;
+
+    // --- STATISTICS ---
+    static const int latencyWindow = 1024; // percentiles cover the most recent jobs
+    QElapsedTimer uptime;
+    quint64 jobsDone;
+    quint64 jobsFailed;
+    QVector<double> latencies;
+    int latencyCursor;
+
+};
+
+#endif // MYDAEMON_H
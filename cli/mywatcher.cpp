@@ -0,0 +1,347 @@
+#include "mywatcher.h"
+
+#include <iostream>
+
+#include <QDateTime>
+#include <QFile>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "mydaemon.h"
+#include "mydispatch.h"
+
+// ----- JOBS -------------------------------------------------------------------------------------
+MyWatchJob::MyWatchJob(QObject *watcher, MyResultCache *results, QList<MyOperation> chain, QString input, QString output) :
+    owner(watcher),
+    cache(results),
+    operations(chain),
+    inputPath(input),
+    outputPath(output)
+{
+    queued.start();
+}
+
+void MyWatchJob::run()
+{
+    double queueMs = queued.nsecsElapsed() / 1e6;
+    QElapsedTimer timer;
+    timer.start();
+
+    QString failure;
+    try
+    {
+        failure = MyDaemonJob::processFile(operations, inputPath, outputPath, cache);
+    }
+    catch(const std::exception &exception)
+    {
+        failure = exception.what();
+    }
+
+    QMetaObject::invokeMethod(owner, "finishFile", Qt::QueuedConnection, Q_ARG(QString, inputPath),
+                              Q_ARG(QString, failure), Q_ARG(double, queueMs), Q_ARG(double, timer.nsecsElapsed() / 1e6));
+}
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyWatcher::MyWatcher(QObject *parent) :
+    QObject(parent),
+    cache(0),
+    capacity(1),
+    settleInterval(0),
+    paused(false),
+    missed(false),
+    processed(0),
+    failed(0)
+#ifdef Q_OS_LINUX
+    ,
+    inotify(-1),
+    notifier(0)
+#endif
+{
+    connect(&settleTimer, SIGNAL(timeout()), this, SLOT(settleFiles()));
+}
+
+MyWatcher::~MyWatcher()
+{
+    settleTimer.stop();
+    pool.waitForDone();
+
+#ifdef Q_OS_LINUX
+    delete notifier;
+    if(inotify >= 0)
+    {
+        close(inotify);
+    }
+#endif
+}
+
+// ----- WATCHING ---------------------------------------------------------------------------------
+bool MyWatcher::watch(QString spoolDirectory, QString outputDirectory, QList<MyOperation> chain,
+                      int threads, int queueSize, int settleMs)
+{
+    spool = QDir(spoolDirectory);
+    output = QDir(outputDirectory);
+    operations = chain;
+    capacity = queueSize > 0 ? queueSize : 1;
+    settleInterval = settleMs > 0 ? settleMs : 0;
+
+    if(!spool.exists())
+    {
+        error = "no directory " + spoolDirectory;
+        return false;
+    }
+    if(!output.mkpath(".") || output.canonicalPath() == spool.canonicalPath())
+    {
+        // results written into the spool would be picked up again
+        error = "the output directory must exist apart from " + spoolDirectory;
+        return false;
+    }
+
+#ifdef Q_OS_LINUX
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify < 0 || inotify_add_watch(inotify, QFile::encodeName(spool.absolutePath()).constData(),
+                                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        error = "cannot watch " + spoolDirectory;
+        return false;
+    }
+    notifier = new QSocketNotifier(inotify, QSocketNotifier::Read);
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+#else
+    if(!watcher.addPath(spool.absolutePath()))
+    {
+        error = "cannot watch " + spoolDirectory;
+        return false;
+    }
+    connect(&watcher, SIGNAL(directoryChanged(QString)), this, SLOT(rescan()));
+#endif
+
+    MyDispatch::getKernels();
+    pool.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+    pool.setExpiryTimeout(-1);
+
+    // checked a few times per interval, a settled file waits at most a quarter of it longer
+    settleTimer.setInterval(qMax<qint64>(settleInterval / 4, 10));
+    settleTimer.start();
+    clock.start();
+
+    // files dropped while nobody was watching
+    rescan();
+    return true;
+}
+
+void MyWatcher::setCache(MyResultCache *results)
+{
+    cache = results;
+}
+
+QString MyWatcher::getError()
+{
+    return error;
+}
+
+quint64 MyWatcher::getProcessed()
+{
+    return processed;
+}
+
+quint64 MyWatcher::getFailed()
+{
+    return failed;
+}
+
+// ----- EVENTS -----------------------------------------------------------------------------------
+void MyWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(struct inotify_event) char buffer[16384];
+    bool overflow = false;
+    ssize_t length = 0;
+
+    while((length = read(inotify, buffer, sizeof(buffer))) > 0)
+    {
+        for(char *cursor = buffer; cursor < buffer + length; )
+        {
+            struct inotify_event *event = (struct inotify_event *)cursor;
+
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+            }
+            else if(event->len > 0)
+            {
+                noticeFile(QFile::decodeName(event->name));
+            }
+            cursor += sizeof(struct inotify_event) + event->len;
+        }
+
+        if(paused)
+        {
+            // the remaining events stay with the kernel until there is room again
+            break;
+        }
+    }
+
+    if(overflow)
+    {
+        rescan();
+    }
+#endif
+}
+
+void MyWatcher::rescan()
+{
+    // oldest first, so a backlog drains in arrival order
+    QStringList names = spool.entryList(QDir::Files, QDir::Time | QDir::Reversed);
+
+    foreach (QString name, names)
+    {
+        noticeFile(name);
+    }
+}
+
+void MyWatcher::noticeFile(QString name)
+{
+    if(!isCandidate(name))
+    {
+        return;
+    }
+
+    QString path = spool.filePath(name);
+    if(settling.contains(path))
+    {
+        // written to again, the settle interval starts over
+        lastEvent[path] = clock.elapsed();
+        return;
+    }
+    if(inFlight.contains(path))
+    {
+        return;
+    }
+
+    if(settling.size() + inFlight.size() >= capacity)
+    {
+        missed = true;
+        setBackPressure(true);
+        return;
+    }
+
+    QFileInfo info(path);
+    if(!info.isFile() || isProcessed(info))
+    {
+        return;
+    }
+
+    settling[path] = info.size();
+    lastEvent[path] = clock.elapsed();
+    setBackPressure(settling.size() + inFlight.size() >= capacity);
+}
+
+void MyWatcher::settleFiles()
+{
+    qint64 now = clock.elapsed();
+    QStringList paths = settling.keys();
+
+    foreach (QString path, paths)
+    {
+        if(now - lastEvent.value(path) < settleInterval)
+        {
+            continue;
+        }
+
+        QFileInfo info(path);
+        if(!info.isFile())
+        {
+            // moved away or deleted before it settled
+            settling.remove(path);
+            lastEvent.remove(path);
+            continue;
+        }
+        if(info.size() != settling.value(path))
+        {
+            settling[path] = info.size();
+            lastEvent[path] = now;
+            continue;
+        }
+
+        settling.remove(path);
+        lastEvent.remove(path);
+        startFile(path);
+    }
+
+    setBackPressure(settling.size() + inFlight.size() >= capacity);
+}
+
+// ----- QUEUE ------------------------------------------------------------------------------------
+void MyWatcher::startFile(QString inputPath)
+{
+    inFlight.insert(inputPath);
+    pool.start(new MyWatchJob(this, cache, operations, inputPath, output.filePath(QFileInfo(inputPath).fileName())));
+}
+
+void MyWatcher::finishFile(QString inputPath, QString failure, double queueMs, double processMs)
+{
+    inFlight.remove(inputPath);
+
+    if(failure.isEmpty())
+    {
+        processed++;
+        std::cerr << QFileInfo(inputPath).fileName().toStdString() << " done in " << queueMs + processMs << " ms" << std::endl;
+    }
+    else
+    {
+        failed++;
+        std::cerr << QFileInfo(inputPath).fileName().toStdString() << " failed: " << failure.toStdString() << std::endl;
+    }
+
+    setBackPressure(settling.size() + inFlight.size() >= capacity);
+}
+
+void MyWatcher::setBackPressure(bool full)
+{
+    if(full == paused)
+    {
+        return;
+    }
+    paused = full;
+
+#ifdef Q_OS_LINUX
+    notifier->setEnabled(!full);
+#endif
+
+    if(full)
+    {
+        std::cerr << "queue full, holding new files in " << spool.path().toStdString() << std::endl;
+        return;
+    }
+
+    if(missed)
+    {
+        missed = false;
+        rescan();
+    }
+}
+
+// ----- FILTERS ----------------------------------------------------------------------------------
+bool MyWatcher::isCandidate(QString name)
+{
+    // hidden and partial names are how most writers stage a file before renaming it into place
+    if(name.startsWith("."))
+    {
+        return false;
+    }
+
+    static const QStringList suffixes = QStringList() << "bmp" << "dib" << "jpeg" << "jpg" << "jpe"
+        << "jp2" << "png" << "pbm" << "pgm" << "ppm" << "tif" << "tiff";
+    return suffixes.contains(QFileInfo(name).suffix().toLower());
+}
+
+bool MyWatcher::isProcessed(QFileInfo input)
+{
+    // an output newer than its input survives a restart, the file is not processed twice
+    QFileInfo result(output.filePath(input.fileName()));
+    return result.exists() && result.lastModified() >= input.lastModified();
+}
@@ -0,0 +1,108 @@
+#ifndef MYWATCHER_H
+#define MYWATCHER_H
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QObject>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#else
+#include <QFileSystemWatcher>
+#endif
+
+#include "myoperation.h"
+#include "myresultcache.h"
+
+// ----- WATCH FOLDER -----
+// processes every image that lands in a spool directory and writes the result with the same name
+// into the output directory. on Linux new files are reported by inotify once their writer closed
+// them (IN_CLOSE_WRITE) or renamed them into the spool (IN_MOVED_TO), other systems rescan the
+// directory on every change. a file is only queued after its size stayed the same for the settle
+// interval, scanners that close and reopen while writing do not get picked up half written.
+// at most queueSize files are settling, queued or running; while the queue is full the inotify
+// descriptor is not read, the kernel keeps the events and a rescan recovers any that overflow
+class MyWatchJob : public QRunnable
+{
+
+public:
+    MyWatchJob(QObject *watcher, MyResultCache *results, QList<MyOperation> chain, QString input, QString output);
+    void run();
+
+private:
+    QObject *owner; // receives the result through a queued call of finishFile
+    MyResultCache *cache; // 0 without --cache
+    QList<MyOperation> operations;
+    QString inputPath;
+    QString outputPath;
+    QElapsedTimer queued;
+};
+
+class MyWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    explicit MyWatcher(QObject *parent = 0);
+    ~MyWatcher();
+
+    // --- WATCHING ---
+    bool watch(QString spoolDirectory, QString outputDirectory, QList<MyOperation> chain,
+               int threads, int queueSize, int settleMs);
+    void setCache(MyResultCache *results);
+    QString getError();
+    quint64 getProcessed();
+    quint64 getFailed();
+
+private slots:
+    void readEvents();
+    void rescan();
+    void settleFiles();
+    void finishFile(QString inputPath, QString failure, double queueMs, double processMs);
+
+private:
+    void noticeFile(QString name);
+    void startFile(QString inputPath);
+    void setBackPressure(bool full);
+    bool isCandidate(QString name);
+    bool isProcessed(QFileInfo input);
+
+    // --- CONFIGURATION ---
+    QDir spool;
+    QDir output;
+    QList<MyOperation> operations;
+    MyResultCache *cache;
+    int capacity;
+    qint64 settleInterval;
+    QString error;
+
+    // --- QUEUE STATE ---
+    QThreadPool pool;
+    QHash<QString, qint64> settling; // size at the last check
+    QHash<QString, qint64> lastEvent; // milliseconds on the clock below
+    QSet<QString> inFlight; // queued in the pool or running
+    bool paused;
+    bool missed; // files were turned away while full, rescan once there is room
+    QElapsedTimer clock;
+    QTimer settleTimer;
+    quint64 processed;
+    quint64 failed;
+
+    // --- NOTIFICATION ---
+#ifdef Q_OS_LINUX
+    int inotify;
+    QSocketNotifier *notifier;
+#else
+    QFileSystemWatcher watcher;
+#endif
+
+};
+
+#endif // MYWATCHER_H
@@ -3,10 +3,14 @@ DEPENDPATH += $$PWD
 
 SOURCES += \
     $$PWD/mainwindow.cpp \
+    $$PWD/myimageitem.cpp \
+    $$PWD/mytilecache.cpp \
     $$PWD/qcustomplot.cpp
 
 HEADERS += \
     $$PWD/mainwindow.h \
+    $$PWD/myimageitem.h \
+    $$PWD/mytilecache.h \
     $$PWD/qcustomplot.h
 
 FORMS += \
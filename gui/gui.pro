@@ -0,0 +1,15 @@
+# the application, it also runs the command line when started with options; the daemon and
+# the watch mode are left to imaging-basics-cli so QtNetwork stays out of the GUI
+
+QT += core gui concurrent widgets printsupport
+
+TARGET = imaging-basics
+TEMPLATE = app
+
+include(../build.pri)
+include(../myimage/myimage-lib.pri)
+include(../res/res.pri)
+include(../cli/cli.pri)
+include(gui.pri)
+
+SOURCES += ../main.cpp
@@ -4,20 +4,44 @@
 #include <cstdlib>
 
 // ----- MAIN WINDOW ------------------------------------------------------------------------------
-MainWindow::MainWindow(QWidget *parent) :
+MainWindow::MainWindow(QWidget *parent, QElapsedTimer startup) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
+    defaultImagesLoaded(false),
+    histogramsCreated(false),
+    startupTimer(startup),
+    startupReported(false),
     inputImage(MyImage("input")),
     bufferImage(MyImage("buffer")),
-    outputImage(MyImage("output"))
-{
+    outputImage(MyImage("output")),
+    previewInputImage(MyImage("preview_input")),
+    previewOutputImage(MyImage("preview_output")),
+    commitPending(false),
+    commitTool(0),
+    committingId(-1),
+    committingValue(0),
+    committedTool(-1),
+    committedId(-1),
+    committedValue(0),
+    tileCache(tileCacheBytes)
+{
+    if(!startupTimer.isValid())
+    {
+        startupTimer.start();
+    }
+    markStartup("main window");
+
     ui->setupUi(this);
+    statisticsLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(statisticsLabel);
+    markStartup("ui");
 
     item = new QGraphicsPixmapItem();
 
     createActions();
     createMenus();
     addActionsToMenu();
+    markStartup("actions");
 
     createGraphics();
     setGraphicsToGUI();
@@ -26,13 +50,33 @@ MainWindow::MainWindow(QWidget *parent) :
     createDefaultImageComboBox();
 
     createHistograms();
+    createPreview();
+    markStartup("constructed");
 }
 
 MainWindow::~MainWindow()
 {
+    // the full resolution pass writes outputImage, let it finish before the members go away
+    commitWatcher.waitForFinished();
     delete ui;
 }
 
+void MainWindow::markStartup(QString phase)
+{
+    startupPhases.append(QString("%1 %2 ms").arg(phase).arg(startupTimer.elapsed()));
+}
+
+void MainWindow::reportStartup()
+{
+    // IMAGING_BASICS_STARTUP=1 prints every phase, e.g. to compare local and remote displays
+    statusBar()->showMessage(tr("Window ready in %1 ms").arg(startupTimer.elapsed()), 5000);
+
+    if(!qgetenv("IMAGING_BASICS_STARTUP").isEmpty())
+    {
+        std::cerr << "startup: " << startupPhases.join(", ").toStdString() << std::endl;
+    }
+}
+
 // ----- MENU AND GUI -----------------------------------------------------------------------------
 void MainWindow::createActions()
 {
@@ -74,6 +118,14 @@ void MainWindow::createActions()
     imageResetAction->setShortcut(QKeySequence::Refresh);
     connect(imageResetAction, SIGNAL(triggered()), this, SLOT(imageReset()));
 
+    imageRegionAction = new QAction(tr("Set Region from &View"), this);
+    imageRegionAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_R));
+    connect(imageRegionAction, SIGNAL(triggered()), this, SLOT(imageRegion()));
+
+    imageRegionClearAction = new QAction(tr("C&lear Region"), this);
+    imageRegionClearAction->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_R));
+    connect(imageRegionClearAction, SIGNAL(triggered()), this, SLOT(imageRegionClear()));
+
     // --- Process Menu Actions ---
     processPositiveAction = new QAction(tr("&Positive"), this);
     processPositiveAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_1));
@@ -100,6 +152,21 @@ void MainWindow::createActions()
     processEqualizationAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_0));
     connect(processEqualizationAction, SIGNAL(triggered()), this, SLOT(processEqualization()));
 
+    processAdaptiveEqualizationAction = new QAction(tr("&Adaptive Equalize"), this);
+    processAdaptiveEqualizationAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_9));
+    connect(processAdaptiveEqualizationAction, SIGNAL(triggered()), this, SLOT(processAdaptiveEqualization()));
+
+    processLocalEqualizationAction = new QAction(tr("&Local Equalize"), this);
+    processLocalEqualizationAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_8));
+    connect(processLocalEqualizationAction, SIGNAL(triggered()), this, SLOT(processLocalEqualization()));
+
+    processAutoContrastAction = new QAction(tr("Auto &Contrast"), this);
+    processAutoContrastAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_7));
+    connect(processAutoContrastAction, SIGNAL(triggered()), this, SLOT(processAutoContrast()));
+
+    processHistogramMatchAction = new QAction(tr("&Match Histogram to File..."), this);
+    connect(processHistogramMatchAction, SIGNAL(triggered()), this, SLOT(processHistogramMatch()));
+
     // --- Help Menu Actions ---
     aboutAction = new QAction(tr("&About This Application"), this);
     connect(aboutAction, SIGNAL(triggered()), this, SLOT(about()));
@@ -130,6 +197,9 @@ void MainWindow::addActionsToMenu()
     imageMenu->addAction(imageUndoAction);
     imageMenu->addAction(imageCopyAction);
     imageMenu->addAction(imageResetAction);
+    imageMenu->addSeparator();
+    imageMenu->addAction(imageRegionAction);
+    imageMenu->addAction(imageRegionClearAction);
 
     processMenu->addAction(processPositiveAction);
     processMenu->addAction(processNegativeAction);
@@ -137,6 +207,10 @@ void MainWindow::addActionsToMenu()
     processMenu->addAction(processScaleAction);
     processMenu->addAction(processNonLinearAction);
     processMenu->addAction(processEqualizationAction);
+    processMenu->addAction(processAdaptiveEqualizationAction);
+    processMenu->addAction(processLocalEqualizationAction);
+    processMenu->addAction(processAutoContrastAction);
+    processMenu->addAction(processHistogramMatchAction);
 
     helpMenu->addAction(aboutAction);
     helpMenu->addAction(aboutQtAction);
@@ -159,18 +233,50 @@ void MainWindow::createButtonGroups()
 
 void MainWindow::createDefaultImageComboBox()
 {
-    setDefaultImageList();
-    ui->comboBoxDefaultFileSelection->addItems(defaultImageList);
+    // filled on first use, so a cold start never opens the sample images
+    ui->comboBoxDefaultFileSelection->installEventFilter(this);
+}
+
+void MainWindow::createPreview()
+{
+    connect(ui->spinBox_nonLinear, SIGNAL(valueChanged(double)), this, SLOT(previewNonLinear()));
+    connect(ui->spinBox_scalingFactor, SIGNAL(valueChanged(double)), this, SLOT(previewScale()));
+    connect(ui->spinBox_nonLinear, SIGNAL(editingFinished()), this, SLOT(commitNonLinear()));
+    connect(ui->spinBox_scalingFactor, SIGNAL(editingFinished()), this, SLOT(commitScale()));
+    connect(&commitWatcher, SIGNAL(finished()), this, SLOT(commitFinished()));
 }
 
 void MainWindow::createHistograms()
 {
-    inputDistributionBars = new QCPBars(ui->qCustomPlotHistogram1->xAxis, ui->qCustomPlotHistogram1->yAxis);
-    outputDistributionBars = new QCPBars(ui->qCustomPlotHistogram2->xAxis, ui->qCustomPlotHistogram2->yAxis);
-    outputPDFBars = new QCPBars(ui->qCustomPlotHistogram3->xAxis, ui->qCustomPlotHistogram3->yAxis);
-    outputCDFBars = new QCPBars(ui->qCustomPlotHistogram4->xAxis, ui->qCustomPlotHistogram4->yAxis);
-    outputTransformBars = new QCPBars(ui->qCustomPlotHistogram5->xAxis, ui->qCustomPlotHistogram5->yAxis);
-    outputEqualizedBars = new QCPBars(ui->qCustomPlotHistogram6->xAxis, ui->qCustomPlotHistogram6->yAxis);
+    // six plots are the most expensive part of the window, they wait until there is something
+    // to show, the first image or the first switch to another histogram tab
+    connect(ui->tabWidget_Histograms, SIGNAL(currentChanged(int)), this, SLOT(createHistogramsOnDemand()));
+}
+
+void MainWindow::createHistogramsOnDemand()
+{
+    if(histogramsCreated)
+    {
+        return;
+    }
+    histogramsCreated = true;
+
+    QWidget *tabs[6] = { ui->tabInputDistribution, ui->tabOutputDistribution, ui->tabBufferPDF,
+                         ui->tabBufferCDF, ui->tabBufferTransform, ui->tabBufferEqualized };
+    for(int i=0; i<6; i++)
+    {
+        histogramPlots[i] = new QCustomPlot(tabs[i]);
+        histogramPlots[i]->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+        histogramPlots[i]->xAxis->setRange(0,256);
+        tabs[i]->layout()->addWidget(histogramPlots[i]);
+    }
+
+    inputDistributionBars = new QCPBars(histogramPlots[0]->xAxis, histogramPlots[0]->yAxis);
+    outputDistributionBars = new QCPBars(histogramPlots[1]->xAxis, histogramPlots[1]->yAxis);
+    outputPDFBars = new QCPBars(histogramPlots[2]->xAxis, histogramPlots[2]->yAxis);
+    outputCDFBars = new QCPBars(histogramPlots[3]->xAxis, histogramPlots[3]->yAxis);
+    outputTransformBars = new QCPBars(histogramPlots[4]->xAxis, histogramPlots[4]->yAxis);
+    outputEqualizedBars = new QCPBars(histogramPlots[5]->xAxis, histogramPlots[5]->yAxis);
 
     inputDistributionBars->setName("Original Histogram");
     outputDistributionBars->setName("Current Histogram");
@@ -186,12 +292,13 @@ void MainWindow::createHistograms()
     outputTransformBars->setPen(QColor("#000000"));
     outputEqualizedBars->setPen(QColor("#000000"));
 
-    ui->qCustomPlotHistogram1->xAxis->setRange(0,256);
-    ui->qCustomPlotHistogram2->xAxis->setRange(0,256);
-    ui->qCustomPlotHistogram3->xAxis->setRange(0,256);
-    ui->qCustomPlotHistogram4->xAxis->setRange(0,256);
-    ui->qCustomPlotHistogram5->xAxis->setRange(0,256);
-    ui->qCustomPlotHistogram6->xAxis->setRange(0,256);
+    if(inputImage.getSize() > 0)
+    {
+        inputDistributionBars->setData(inputImage.intensityBins, inputImage.intensityDistribution);
+        histogramPlots[0]->yAxis->rescale();
+        updateOutputHistograms(outputImage);
+    }
+    markStartup("histograms");
 }
 
 // ----- GRAPHICS ---------------------------------------------------------------------------------
@@ -222,7 +329,8 @@ void MainWindow::loadGraphics(QString filePath)
 
 void MainWindow::loadGraphicsDefault()
 {
-    inputImage.setImageToDefault(QString(":/") + ui->comboBoxDefaultFileSelection->currentText());
+    populateDefaultImages();
+    inputImage.setImageToDefault(defaultImageRoot + ui->comboBoxDefaultFileSelection->currentText());
 }
 
 void MainWindow::setGraphicsToGUI()
@@ -230,42 +338,219 @@ void MainWindow::setGraphicsToGUI()
     ui->graphicsView_image_input->setScene(inputScene);
     ui->graphicsView_image_buffer->setScene(bufferScene);
     ui->graphicsView_image_output->setScene(outputScene);
+
+    // ctrl + wheel zooms, the image items pick the matching pyramid level while painting
+    ui->graphicsView_image_input->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    ui->graphicsView_image_buffer->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    ui->graphicsView_image_output->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+
+    ui->graphicsView_image_input->viewport()->installEventFilter(this);
+    ui->graphicsView_image_buffer->viewport()->installEventFilter(this);
+    ui->graphicsView_image_output->viewport()->installEventFilter(this);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if(!startupReported && event->type() == QEvent::Paint && watched == ui->graphicsView_image_input->viewport())
+    {
+        // the paint is still running, report once the event loop is idle again
+        startupReported = true;
+        markStartup("first paint");
+        QTimer::singleShot(0, this, SLOT(reportStartup()));
+    }
+
+    if(watched == ui->comboBoxDefaultFileSelection && !defaultImagesLoaded)
+    {
+        if(event->type() == QEvent::MouseButtonPress || event->type() == QEvent::KeyPress ||
+           event->type() == QEvent::FocusIn)
+        {
+            populateDefaultImages();
+        }
+    }
+
+    if(event->type() == QEvent::Resize && watched == ui->graphicsView_image_output->viewport() &&
+       bufferImage.getSize() > 0)
+    {
+        // the proxy follows the view size, it comes from the cached pyramid so this stays cheap
+        buildPreview();
+    }
+
+    if(event->type() == QEvent::Wheel)
+    {
+        QWheelEvent *wheelEvent = static_cast<QWheelEvent *>(event);
+        QGraphicsView *view = qobject_cast<QGraphicsView *>(watched->parent());
+
+        if(view && (wheelEvent->modifiers() & Qt::ControlModifier))
+        {
+            double factor = (wheelEvent->angleDelta().y() > 0) ? 1.25 : 0.8;
+            view->scale(factor, factor);
+            return true;
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
 }
 
 void MainWindow::updateGraphics()
 {
+    // whatever changed the output, the next commit has to run again
+    committedTool = -1;
     clearGraphics();
 
-    inputScene->addPixmap(QPixmap::fromImage(inputImage.getQImage()));
-    bufferScene->addPixmap(QPixmap::fromImage(bufferImage.getQImage()));
-    outputScene->addPixmap(QPixmap::fromImage(outputImage.getQImage()));
+    // the items only paint levels that already exist
+    inputImage.buildPyramid();
+    bufferImage.buildPyramid();
+    outputImage.buildPyramid();
 
+    inputScene->addItem(new MyImageItem(&inputImage, &tileCache));
+    bufferScene->addItem(new MyImageItem(&bufferImage, &tileCache));
+    outputScene->addItem(new MyImageItem(&outputImage, &tileCache));
+
+    createHistogramsOnDemand();
     inputDistributionBars->setData(inputImage.intensityBins, inputImage.intensityDistribution);
-    outputDistributionBars->setData(outputImage.intensityBins, outputImage.intensityDistribution);
-    outputPDFBars->setData(outputImage.intensityBins, outputImage.intensityPDF);
-    outputCDFBars->setData(outputImage.intensityBins, outputImage.intensityCDF);
-    outputTransformBars->setData(outputImage.intensityBins, outputImage.intensityTransform);
-    outputEqualizedBars->setData(outputImage.intensityBins, outputImage.intensityEqualized);
-
-    ui->qCustomPlotHistogram1->yAxis->rescale();
-    ui->qCustomPlotHistogram2->yAxis->rescale();
-    ui->qCustomPlotHistogram3->yAxis->rescale();
-    ui->qCustomPlotHistogram4->yAxis->rescale();
-    ui->qCustomPlotHistogram5->yAxis->rescale();
-    ui->qCustomPlotHistogram6->yAxis->rescale();
-
-    ui->qCustomPlotHistogram1->replot();
-    ui->qCustomPlotHistogram2->replot();
-    ui->qCustomPlotHistogram3->replot();
-    ui->qCustomPlotHistogram4->replot();
-    ui->qCustomPlotHistogram5->replot();
-    ui->qCustomPlotHistogram6->replot();
- }
+    histogramPlots[0]->yAxis->rescale();
+    histogramPlots[0]->replot();
+
+    updateOutputHistograms(outputImage);
+}
+
+void MainWindow::updateOutputHistograms(MyImage image)
+{
+    updateStatistics(image);
+
+    if(!histogramsCreated)
+    {
+        return;
+    }
+
+    outputDistributionBars->setData(image.intensityBins, image.intensityDistribution);
+    outputPDFBars->setData(image.intensityBins, image.intensityPDF);
+    outputCDFBars->setData(image.intensityBins, image.intensityCDF);
+    outputTransformBars->setData(image.intensityBins, image.intensityTransform);
+    outputEqualizedBars->setData(image.intensityBins, image.intensityEqualized);
+
+    for(int i=1; i<6; i++)
+    {
+        histogramPlots[i]->yAxis->rescale();
+        histogramPlots[i]->replot();
+    }
+}
+
+void MainWindow::updateStatistics(MyImage &image)
+{
+    // from the histogram that was just plotted, no pixel is read
+    MyStatistics statistics = image.getStatistics();
+
+    if(statistics.count == 0)
+    {
+        statisticsLabel->clear();
+        return;
+    }
+
+    statisticsLabel->setText(tr("mean %1  sd %2  median %3  p1-p99 %4-%5  min-max %6-%7  entropy %8 bits")
+        .arg(statistics.mean, 0, 'f', 1).arg(statistics.standardDeviation, 0, 'f', 1).arg(statistics.median)
+        .arg(statistics.getPercentile(1)).arg(statistics.getPercentile(99))
+        .arg(statistics.minimum).arg(statistics.maximum).arg(statistics.entropy, 0, 'f', 2));
+}
+
+// ----- PREVIEW ----------------------------------------------------------------------------------
+void MainWindow::buildPreview()
+{
+    // the proxy is cached per buffer state and never larger than the output view
+    QSize viewSize = ui->graphicsView_image_output->viewport()->size();
+    previewInputImage.setImageToProxy(bufferImage, viewSize.height(), viewSize.width());
+    previewOutputImage.setImageMatchZero(previewInputImage);
+}
+
+void MainWindow::updatePreviewGraphics()
+{
+    outputScene->clear();
+
+    MyImageItem *previewItem = new MyImageItem(&previewOutputImage, &tileCache);
+    outputScene->addItem(previewItem);
+
+    if(previewOutputImage.getCols() > 0)
+    {
+        // keep the scene in full resolution coordinates so the view does not jump on commit
+        previewItem->setScale(1.0 * bufferImage.getCols() / previewOutputImage.getCols());
+    }
+
+    updateOutputHistograms(previewOutputImage);
+}
+
+void MainWindow::updateLazyGraphics()
+{
+    // while the worker writes outputImage, the output view maps the visible buffer tiles
+    // through the preview LUT, so the visible area is final first and the rest fills in
+    outputScene->clear();
+
+    MyImageItem *lazyItem = new MyImageItem(&bufferImage, &tileCache);
+    lazyItem->setIntensityLookup(previewOutputImage.intensityCalculation);
+    outputScene->addItem(lazyItem);
+}
+
+void MainWindow::applyNonLinear(MyImage input, int id, double value)
+{
+    switch (id) {
+    case 0:
+        outputImage.processExponential(input);
+        break;
+    case 1:
+        outputImage.processNaturalLog(input);
+        break;
+    case 2:
+        outputImage.processPowerLaw(input,value);
+        break;
+    case 3:
+        outputImage.processBaseLog(input,value);
+        break;
+    default:
+        break;
+    }
+
+    // off the GUI thread when called from a commit
+    outputImage.buildPyramid();
+}
+
+void MainWindow::applyScale(MyImage input, int id, double value)
+{
+    switch (id) {
+    case 0:
+        outputImage.processScaleUp(input,value);
+        break;
+    case 1:
+        outputImage.processScaleDown(input,value);
+        break;
+    default:
+        break;
+    }
+
+    // off the GUI thread when called from a commit
+    outputImage.buildPyramid();
+}
+
+void MainWindow::setProcessingEnabled(bool enabled)
+{
+    foreach (QAction *action, fileMenu->actions())
+    {
+        action->setEnabled(enabled);
+    }
+
+    foreach (QAction *action, imageMenu->actions())
+    {
+        action->setEnabled(enabled);
+    }
+
+    foreach (QAction *action, processMenu->actions())
+    {
+        action->setEnabled(enabled);
+    }
+}
 
 // ----- BUFFER -----------------------------------------------------------------------------------
 void MainWindow::forwardBuffer()
 {
     bufferImage.processPositive(outputImage);
+    buildPreview();
 }
 
 void MainWindow::reverseBuffer()
@@ -276,6 +561,7 @@ void MainWindow::reverseBuffer()
 void MainWindow::resetBuffer()
 {
     bufferImage.processPositive(inputImage);
+    buildPreview();
 }
 
 // ----- FILE MENU SLOTS --------------------------------------------------------------------------
@@ -368,6 +654,38 @@ void MainWindow::imageCopy()
     updateGraphics();
 }
 
+void MainWindow::imageRegion()
+{
+    // restrict processing and histograms to the part of the image visible in the output view
+    QGraphicsView *view = ui->graphicsView_image_output;
+    QRectF visible = view->mapToScene(view->viewport()->rect()).boundingRect();
+    QRectF bounds(0, 0, bufferImage.getCols(), bufferImage.getRows());
+    QRect selection = visible.intersected(bounds).toAlignedRect();
+
+    if(selection.isEmpty())
+    {
+        return;
+    }
+
+    bufferImage.setRegionOfInterest(selection.x(), selection.y(), selection.width(), selection.height());
+    outputImage.setRegionOfInterest(selection.x(), selection.y(), selection.width(), selection.height());
+
+    statusBar()->showMessage(tr("Region %1 x %2 at (%3, %4)")
+        .arg(selection.width()).arg(selection.height()).arg(selection.x()).arg(selection.y()));
+    updateGraphics();
+}
+
+void MainWindow::imageRegionClear()
+{
+    bufferImage.clearRegionOfInterest();
+    outputImage.clearRegionOfInterest();
+    bufferImage.setIntensityHistograms();
+    outputImage.setIntensityHistograms();
+
+    statusBar()->clearMessage();
+    updateGraphics();
+}
+
 // ----- PROCESS MENU SLOTS -----------------------------------------------------------------------
 void MainWindow::processPositive()
 {
@@ -399,47 +717,199 @@ void MainWindow::processBitShift()
 
 void MainWindow::processScale()
 {
+    applyScale(bufferImage, scalingButtonGroup.checkedId(), ui->spinBox_scalingFactor->value());
+    updateGraphics();
+}
 
-    switch (scalingButtonGroup.checkedId()) {
-    case 0:
-        outputImage.processScaleUp(bufferImage,ui->spinBox_scalingFactor->value());
-        break;
-    case 1:
-        outputImage.processScaleDown(bufferImage,ui->spinBox_scalingFactor->value());
-        break;
-    default:
-        break;
+void MainWindow::processNonLinear()
+{
+    applyNonLinear(bufferImage, nonLinearButtonGroup.checkedId(), ui->spinBox_nonLinear->value());
+    updateGraphics();
+}
+
+void MainWindow::processEqualization()
+{
+    // in place, the output histogram is derived from the lookup instead of a second pixel pass
+    outputImage.processEqualize(outputImage);
+    updateGraphics();
+}
+
+void MainWindow::processAdaptiveEqualization()
+{
+    outputImage.processAdaptiveEqualize(outputImage, ui->spinBox_tileGrid->value(), ui->spinBox_tileGrid->value(),
+        ui->spinBox_clipLimit->value());
+    updateGraphics();
+}
+
+void MainWindow::processLocalEqualization()
+{
+    outputImage.processLocalEqualize(outputImage, ui->spinBox_localRadius->value());
+    updateGraphics();
+}
+
+void MainWindow::processAutoContrast()
+{
+    // 0.5 % of the pixels at each end are clipped, the rest is stretched over the full range
+    outputImage.processAutoContrast(outputImage, 0.5, 0.5);
+    updateGraphics();
+}
+
+void MainWindow::processHistogramMatch()
+{
+    QString referencePath = QFileDialog::getOpenFileName(this,
+        tr("Select Reference Image"),
+        QDir::homePath(),
+        tr("Image Files (*.png *.jpg *.jpeg *.bmp *.tif *.tiff)"));
+
+    if(referencePath.isNull())
+    {
+        return;
     }
 
+    MyImage referenceImage("reference");
+    referenceImage.setImageFromPath(referencePath.toStdString());
+
+    if(!outputImage.processHistogramMatch(bufferImage, referenceImage))
+    {
+        statusBar()->showMessage(tr("Histogram matching needs 8 bit images"), 5000);
+        return;
+    }
     updateGraphics();
 }
 
-void MainWindow::processNonLinear()
+// ----- PREVIEW SLOTS --------------------------------------------------------------------------
+void MainWindow::previewNonLinear()
 {
+    if(previewInputImage.getSize() == 0)
+    {
+        return;
+    }
+
     switch (nonLinearButtonGroup.checkedId()) {
     case 0:
-        outputImage.processExponential(bufferImage);
+        previewOutputImage.processExponential(previewInputImage);
         break;
     case 1:
-        outputImage.processNaturalLog(bufferImage);
+        previewOutputImage.processNaturalLog(previewInputImage);
         break;
     case 2:
-        outputImage.processPowerLaw(bufferImage,ui->spinBox_nonLinear->value());
+        previewOutputImage.processPowerLaw(previewInputImage,ui->spinBox_nonLinear->value());
         break;
     case 3:
-        outputImage.processBaseLog(bufferImage,ui->spinBox_nonLinear->value());
+        previewOutputImage.processBaseLog(previewInputImage,ui->spinBox_nonLinear->value());
         break;
     default:
+        return;
+    }
+
+    previewOutputImage.setIntensityHistogramsFromSource(bufferImage);
+    updatePreviewGraphics();
+}
+
+void MainWindow::previewScale()
+{
+    if(previewInputImage.getSize() == 0)
+    {
+        return;
+    }
+
+    switch (scalingButtonGroup.checkedId()) {
+    case 0:
+        previewOutputImage.processScaleUp(previewInputImage,ui->spinBox_scalingFactor->value());
         break;
+    case 1:
+        previewOutputImage.processScaleDown(previewInputImage,ui->spinBox_scalingFactor->value());
+        break;
+    default:
+        return;
     }
 
-    updateGraphics();
+    previewOutputImage.setIntensityHistogramsFromSource(bufferImage);
+    updatePreviewGraphics();
 }
 
-void MainWindow::processEqualization()
+void MainWindow::commitNonLinear()
 {
-    outputImage.processEqualize(outputImage);
+    commitTool = 0;
+
+    if(commitWatcher.isRunning())
+    {
+        commitPending = true;
+        return;
+    }
+
+    int id = nonLinearButtonGroup.checkedId();
+    double value = ui->spinBox_nonLinear->value();
+
+    // editingFinished also fires when the spin box only loses focus
+    if(bufferImage.getSize() == 0 || isCommitted(id, value))
+    {
+        return;
+    }
+
+    previewNonLinear();
+    updateLazyGraphics();
+    setProcessingEnabled(false);
+    committingId = id;
+    committingValue = value;
+    commitWatcher.setFuture(QtConcurrent::run(this, &MainWindow::applyNonLinear, bufferImage, id, value));
+}
+
+void MainWindow::commitScale()
+{
+    commitTool = 1;
+
+    if(commitWatcher.isRunning())
+    {
+        commitPending = true;
+        return;
+    }
+
+    int id = scalingButtonGroup.checkedId();
+    double value = ui->spinBox_scalingFactor->value();
+
+    // editingFinished also fires when the spin box only loses focus
+    if(bufferImage.getSize() == 0 || isCommitted(id, value))
+    {
+        return;
+    }
+
+    previewScale();
+    updateLazyGraphics();
+    setProcessingEnabled(false);
+    committingId = id;
+    committingValue = value;
+    commitWatcher.setFuture(QtConcurrent::run(this, &MainWindow::applyScale, bufferImage, id, value));
+}
+
+void MainWindow::commitFinished()
+{
+    setProcessingEnabled(true);
+
+    if(commitPending)
+    {
+        // the value changed while the full resolution pass was running, run it again
+        commitPending = false;
+        if(commitTool == 0)
+        {
+            commitNonLinear();
+        }
+        else
+        {
+            commitScale();
+        }
+        return;
+    }
+
     updateGraphics();
+    committedTool = commitTool;
+    committedId = committingId;
+    committedValue = committingValue;
+}
+
+bool MainWindow::isCommitted(int id, double value) const
+{
+    return committedTool == commitTool && committedId == id && committedValue == value;
 }
 
 // ----- HELP MENU SLOTS -----------------------------------------------------------------------
@@ -458,35 +928,55 @@ void MainWindow::help1()
     // TODO: add some generic help menu item
 }
 
-void MainWindow::setDefaultImageList()
-{
-    defaultImageList.append("apple.jpg");
-    defaultImageList.append("astronaut.jpg");
-    defaultImageList.append("chart_blue.bmp");
-    defaultImageList.append("chart_color.bmp");
-    defaultImageList.append("chart_gray.bmp");
-    defaultImageList.append("chart_green.bmp");
-    defaultImageList.append("chart_red.bmp");
-    defaultImageList.append("elephants.jpg");
-    defaultImageList.append("field.jpg");
-    defaultImageList.append("fountain.jpg");
-    defaultImageList.append("lady.jpg");
-    defaultImageList.append("Lenna.png");
-    defaultImageList.append("Lenna_old.jpeg");
-    defaultImageList.append("octopus.jpg");
-    defaultImageList.append("pollen.jpg");
-    defaultImageList.append("rectangle.bmp");
-    defaultImageList.append("rectangle.png");
-    defaultImageList.append("rectangle.tif");
-    defaultImageList.append("rectangle51.png");
-    defaultImageList.append("rose.jpg");
-    defaultImageList.append("snails.jpg");
-    defaultImageList.append("strawberries.bmp");
-    defaultImageList.append("strawberries.jpg");
-    defaultImageList.append("strawberries.png");
-    defaultImageList.append("test_pattern.png");
-    defaultImageList.append("test_pattern.tif");
-    defaultImageList.append("woman.bmp");
-    defaultImageList.append("woman.png");
-    defaultImageList.append("woman.tif");
+void MainWindow::populateDefaultImages()
+{
+    if(defaultImagesLoaded)
+    {
+        return;
+    }
+    defaultImagesLoaded = true;
+    defaultImageRoot = findDefaultImages();
+
+    QStringList filters;
+    filters << "*.bmp" << "*.jpg" << "*.jpeg" << "*.png" << "*.tif";
+    QStringList names = QDir(defaultImageRoot).entryList(filters, QDir::Files, QDir::Name | QDir::IgnoreCase);
+    ui->comboBoxDefaultFileSelection->addItems(names);
+
+    if(names.isEmpty())
+    {
+        statusBar()->showMessage(tr("No sample images, set IMAGING_BASICS_SAMPLES to an images.rcc or a directory"));
+    }
+}
+
+QString MainWindow::findDefaultImages()
+{
+    // IMAGING_BASICS_SAMPLES may name an .rcc bundle or a plain directory of images, otherwise
+    // images.rcc is looked up next to the executable and in the bundle resources
+    QString applicationDir = QCoreApplication::applicationDirPath();
+    QStringList candidates;
+    candidates << QString::fromLocal8Bit(qgetenv("IMAGING_BASICS_SAMPLES"))
+               << applicationDir + "/images.rcc"
+               << applicationDir + "/../images.rcc"
+               << applicationDir + "/../Resources/images.rcc";
+
+    foreach (QString candidate, candidates)
+    {
+        QFileInfo info(candidate);
+
+        if(candidate.isEmpty() || !info.exists())
+        {
+            continue;
+        }
+
+        if(info.isDir())
+        {
+            return info.absoluteFilePath() + "/";
+        }
+
+        if(QResource::registerResource(info.absoluteFilePath()))
+        {
+            break;
+        }
+    }
+    return ":/samples/";
 }
@@ -13,22 +13,35 @@
 #include <QDir>
 #include <QFile>
 #include <QFileDialog>
+#include <QResource>
+
+// ----- PROFILING -----
+#include <QElapsedTimer>
+
+// ----- CONCURRENCY -----
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 // ----- Q  -----
 #include <QGraphicsItem>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QWheelEvent>
 #include <QStandardPaths>
+#include <QLabel>
+#include <QStatusBar>
 
 // ----- OPENCV IMAGING LIBRARIES -----
 #include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
 
 // ----- QCUSTOMPLOT -----
 #include "qcustomplot.h"
 
 // ----- MY CLASSES -----
 #include "myimage.h"
+#include "myimageitem.h"
+#include "mytilecache.h"
 
 // ----- PRELOADED CLASSES ----- //may not be necessary?
 class QAction;
@@ -47,9 +60,12 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = 0);
+    explicit MainWindow(QWidget *parent = 0, QElapsedTimer startup = QElapsedTimer());
     ~MainWindow();
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
 private slots:
     // --- FILE MENU SLOTS ---
     void close();
@@ -63,15 +79,32 @@ private slots:
     void imageCopy();
     void imageReset();
     void imageUndo();
+    void imageRegion();
+    void imageRegionClear();
 
     // --- PROCESS MENU SLOTS ---
     void processBitShift();
     void processEqualization();
+    void processAdaptiveEqualization();
+    void processLocalEqualization();
+    void processAutoContrast();
+    void processHistogramMatch();
     void processNegative();
     void processNonLinear();
     void processPositive();
     void processScale();
 
+    // --- PREVIEW SLOTS ---
+    void previewNonLinear();
+    void previewScale();
+    void commitNonLinear();
+    void commitScale();
+    void commitFinished();
+
+    // --- DEFERRED CONSTRUCTION SLOTS ---
+    void createHistogramsOnDemand();
+    void reportStartup();
+
     // --- HELP MENU SLOTS ---
     void about();
     void aboutQt();
@@ -91,6 +124,7 @@ private:
     void createDefaultImageComboBox();
     void createMenus();
     void createHistograms();
+    void createPreview();
 
     // --- GRAPHICS ---
     void clearGraphics();
@@ -100,6 +134,16 @@ private:
     void loadGraphicsDefault();
     void setGraphicsToGUI();
     void updateGraphics();
+    void updateOutputHistograms(MyImage image);
+    void updateStatistics(MyImage &image);
+
+    // --- PREVIEW ---
+    void applyNonLinear(MyImage input, int id, double value);
+    void applyScale(MyImage input, int id, double value);
+    void buildPreview();
+    void updatePreviewGraphics();
+    void updateLazyGraphics();
+    void setProcessingEnabled(bool enabled);
 
     // --- BUFFER ---
     void forwardBuffer();
@@ -109,8 +153,10 @@ private:
     // --- FILE IO ---
     void openCommands();
     void saveCommands(QString filePath);
-    void setDefaultImageList();
-    QList<QString> defaultImageList;
+    void populateDefaultImages();
+    QString findDefaultImages();
+    QString defaultImageRoot; // ":/samples/" or a directory, with a trailing slash
+    bool defaultImagesLoaded;
 
     // --- MENUS ---
     QMenu *fileMenu;
@@ -130,6 +176,8 @@ private:
     QAction *imageResetAction;
     QAction *imageUndoAction;
     QAction *imageCopyAction;
+    QAction *imageRegionAction;
+    QAction *imageRegionClearAction;
 
     // --- PROCESS MENU ACTIONS ---
     QAction *processPositiveAction;
@@ -138,6 +186,10 @@ private:
     QAction *processScaleAction;
     QAction *processNonLinearAction;
     QAction *processEqualizationAction;
+    QAction *processAdaptiveEqualizationAction;
+    QAction *processLocalEqualizationAction;
+    QAction *processAutoContrastAction;
+    QAction *processHistogramMatchAction;
 
     // --- HELP MENU ACTIONS ---
     QAction *aboutAction;
@@ -158,18 +210,44 @@ private:
     QGraphicsScene *bufferScene;
 
     // --- HISTOGRAMS ----
+    bool histogramsCreated; // the plots are built on the first image or the first tab switch
+    QCustomPlot *histogramPlots[6];
     QCPBars *inputDistributionBars;
     QCPBars *outputDistributionBars;
     QCPBars *outputPDFBars;
     QCPBars *outputCDFBars;
     QCPBars *outputTransformBars;
     QCPBars *outputEqualizedBars;
+    QLabel *statisticsLabel; // permanent status bar entry, summary of the current histogram
+
+    // --- STARTUP PROFILING ---
+    QElapsedTimer startupTimer; // started in main before QApplication
+    QStringList startupPhases;
+    bool startupReported;
+    void markStartup(QString phase);
 
     // --- MYIMAGE CLASS OBJECTS ---
     MyImage inputImage;
     MyImage bufferImage;
     MyImage outputImage;
 
+    // --- PREVIEW PROXIES ---
+    MyImage previewInputImage;
+    MyImage previewOutputImage;
+    QFutureWatcher<void> commitWatcher;
+    bool commitPending;
+    int commitTool; // 0 = non-linear, 1 = scaling
+    int committingId;
+    double committingValue;
+    int committedTool; // -1 until the output holds a finished commit
+    int committedId;
+    double committedValue;
+    bool isCommitted(int id, double value) const;
+
+    // --- DISPLAY TILES ---
+    static const int tileCacheBytes = 64 * 1024 * 1024; // shared by the three scenes
+    MyTileCache tileCache;
+
 };
 
 #endif // MAINWINDOW_H
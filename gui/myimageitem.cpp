@@ -0,0 +1,191 @@
+#include "myimageitem.h"
+
+static quint64 nextLookupVersion = 1;
+
+const int MyImageItem::tileSize;
+const int MyImageItem::paintBudget;
+const int MyImageItem::fallbackLevels;
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyImageItem::MyImageItem(MyImage *input, MyTileCache *cache, QGraphicsItem *parent) :
+    QGraphicsObject(parent),
+    sourceImage(input),
+    tileCache(cache),
+    sourceRect(0, 0, input->getCols(), input->getRows()),
+    lookupVersion(0),
+    refreshPending(false)
+{
+    // exposedRect is only filled in when the extended style option is requested
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+MyImageItem::~MyImageItem()
+{
+    // destructor call goes here
+}
+
+// ----- LAZY TRANSFORM ---------------------------------------------------------------------------
+void MyImageItem::setIntensityLookup(QVector<double> lookup)
+{
+    lookupTable.create(1, MyImage::numberBins, CV_8UC1);
+
+    int tmp = -1;
+    for(uint16_t i=0; i<MyImage::numberBins; i++)
+    {
+        tmp = round(lookup.at(i));
+        lookupTable.at<uchar>(0,i) = std::max(0, std::min((int)MyImage::maxBin, tmp));
+    }
+
+    // the GUI thread is the only writer, a plain counter keeps the tile keys apart
+    lookupVersion = nextLookupVersion++;
+    update();
+}
+
+// ----- QGRAPHICSITEM INTERFACE ------------------------------------------------------------------
+QRectF MyImageItem::boundingRect() const
+{
+    return sourceRect;
+}
+
+void MyImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    if(sourceRect.isEmpty())
+    {
+        return;
+    }
+
+    // choose the pyramid level matching the current zoom, levels are built when the image changes
+    // and never here, a missing one falls back to the finest level that exists
+    double scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    uint8_t level = sourceImage->getBuiltPyramidLevel(sourceImage->getPyramidLevelForScale(scale));
+    cv::Mat levelImage = sourceImage->getPyramidLevel(level);
+
+    double levelScaleX = 1.0 * levelImage.cols / sourceRect.width();
+    double levelScaleY = 1.0 * levelImage.rows / sourceRect.height();
+
+    // only tiles intersecting the viewport are converted
+    QRectF exposed = option->exposedRect.intersected(sourceRect);
+    if(exposed.isEmpty())
+    {
+        return;
+    }
+
+    quint32 colFirst = std::max(0.0, floor(exposed.left() * levelScaleX / tileSize));
+    quint32 rowFirst = std::max(0.0, floor(exposed.top() * levelScaleY / tileSize));
+    quint32 colLast = std::min((levelImage.cols - 1) / tileSize, (int)(exposed.right() * levelScaleX / tileSize));
+    quint32 rowLast = std::min((levelImage.rows - 1) / tileSize, (int)(exposed.bottom() * levelScaleY / tileSize));
+
+    QElapsedTimer timer;
+    timer.start();
+    bool complete = true;
+
+    for(quint32 row=rowFirst; row<=rowLast; row++) {
+        for(quint32 col=colFirst; col<=colLast; col++)
+        {
+            MyTileKey key = getTileKey(level, col, row);
+            QPixmap *tile = tileCache->find(key);
+
+            if(tile)
+            {
+                painter->drawPixmap(getTileRect(level, col, row), *tile, QRectF(tile->rect()));
+            }
+            else if(timer.elapsed() < paintBudget)
+            {
+                QPixmap converted = convertTile(level, col, row);
+                tileCache->insert(key, converted);
+                painter->drawPixmap(getTileRect(level, col, row), converted, QRectF(converted.rect()));
+            }
+            else
+            {
+                // out of budget, show a coarser tile and come back on the next event loop pass
+                complete = false;
+                paintFallback(painter, level, col, row);
+            }
+        }
+    }
+
+    if(!complete && !refreshPending)
+    {
+        refreshPending = true;
+        QTimer::singleShot(0, this, SLOT(refresh()));
+    }
+}
+
+void MyImageItem::refresh()
+{
+    refreshPending = false;
+    update();
+}
+
+// ----- TILES ------------------------------------------------------------------------------------
+MyTileKey MyImageItem::getTileKey(uint8_t level, quint32 col, quint32 row)
+{
+    MyTileKey key;
+    key.imageVersion = sourceImage->getImageVersion();
+    key.lookupVersion = lookupVersion;
+    key.level = level;
+    key.col = col;
+    key.row = row;
+    return key;
+}
+
+QRectF MyImageItem::getTileRect(uint8_t level, quint32 col, quint32 row)
+{
+    cv::Mat levelImage = sourceImage->getPyramidLevel(level);
+
+    double levelScaleX = 1.0 * levelImage.cols / sourceRect.width();
+    double levelScaleY = 1.0 * levelImage.rows / sourceRect.height();
+
+    int left = col * tileSize;
+    int top = row * tileSize;
+    int width = std::min(tileSize, levelImage.cols - left);
+    int height = std::min(tileSize, levelImage.rows - top);
+
+    return QRectF(left / levelScaleX, top / levelScaleY, width / levelScaleX, height / levelScaleY);
+}
+
+QPixmap MyImageItem::convertTile(uint8_t level, quint32 col, quint32 row)
+{
+    cv::Mat levelImage = sourceImage->getPyramidLevel(level);
+
+    int left = col * tileSize;
+    int top = row * tileSize;
+    cv::Mat tile = levelImage(cv::Rect(left, top,
+        std::min(tileSize, levelImage.cols - left), std::min(tileSize, levelImage.rows - top)));
+
+    cv::Mat mapped;
+    if(!lookupTable.empty())
+    {
+        cv::LUT(tile, lookupTable, mapped);
+        tile = mapped;
+    }
+
+    QImage tileImage((const uchar *) tile.data, tile.cols, tile.rows, tile.step, QImage::Format_Grayscale8);
+    return QPixmap::fromImage(tileImage); // deep copy, the tile header goes out of scope
+}
+
+bool MyImageItem::paintFallback(QPainter *painter, uint8_t level, quint32 col, quint32 row)
+{
+    QRectF target = getTileRect(level, col, row);
+
+    for(uint8_t k=1; k<=fallbackLevels; k++)
+    {
+        QPixmap *coarse = tileCache->find(getTileKey(level + k, col >> k, row >> k));
+
+        if(coarse)
+        {
+            // the fine tile covers a 1/2^k sub-square of the coarse tile
+            double reduction = 1 << k;
+            QRectF source(col * tileSize / reduction - (col >> k) * tileSize,
+                          row * tileSize / reduction - (row >> k) * tileSize,
+                          tileSize / reduction, tileSize / reduction);
+            painter->drawPixmap(target, *coarse, source.intersected(QRectF(coarse->rect())));
+            return true;
+        }
+    }
+
+    painter->fillRect(target, Qt::darkGray);
+    return false;
+}
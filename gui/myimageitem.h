@@ -0,0 +1,57 @@
+#ifndef MYIMAGEITEM_H
+#define MYIMAGEITEM_H
+
+#include <QElapsedTimer>
+#include <QGraphicsObject>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QTimer>
+
+#include "myimage.h"
+#include "mytilecache.h"
+
+class MyImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    // --- TILE SETTINGS ---
+    static const int tileSize = 256; // tile edge in pixels of the pyramid level
+    static const int paintBudget = 12; // milliseconds of tile conversion per paint call
+    static const int fallbackLevels = 3; // coarser levels searched for a placeholder tile
+
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyImageItem(MyImage *input, MyTileCache *cache, QGraphicsItem *parent = 0);
+    ~MyImageItem();
+
+    // --- LAZY TRANSFORM ---
+    void setIntensityLookup(QVector<double> lookup);
+
+    // --- QGRAPHICSITEM INTERFACE ---
+    QRectF boundingRect() const;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+private slots:
+    void refresh();
+
+private:
+    // --- TILES ---
+    MyTileKey getTileKey(uint8_t level, quint32 col, quint32 row);
+    QRectF getTileRect(uint8_t level, quint32 col, quint32 row);
+    QPixmap convertTile(uint8_t level, quint32 col, quint32 row);
+    bool paintFallback(QPainter *painter, uint8_t level, quint32 col, quint32 row);
+
+    // --- SOURCE IMAGE ---
+    MyImage *sourceImage; // owned by the main window, outlives the scene item
+    MyTileCache *tileCache; // shared by all scenes
+    QRectF sourceRect; // full resolution bounds in scene units
+
+    // --- LAZY TRANSFORM ---
+    cv::Mat lookupTable; // applied per tile while converting, empty for the plain source
+    quint64 lookupVersion;
+
+    bool refreshPending;
+
+};
+
+#endif // MYIMAGEITEM_H
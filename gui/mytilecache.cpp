@@ -0,0 +1,58 @@
+#include "mytilecache.h"
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyTileCache::MyTileCache(int maxBytes) :
+    tiles(maxBytes),
+    hits(0),
+    misses(0)
+{
+}
+
+MyTileCache::~MyTileCache()
+{
+    // destructor call goes here
+}
+
+// ----- TILE ACCESS ------------------------------------------------------------------------------
+QPixmap *MyTileCache::find(MyTileKey key)
+{
+    // QCache::object() also moves the tile to the front of the LRU list
+    QPixmap *tile = tiles.object(key);
+
+    if(tile)
+    {
+        hits++;
+    }
+    else
+    {
+        misses++;
+    }
+    return tile;
+}
+
+void MyTileCache::insert(MyTileKey key, QPixmap tile)
+{
+    int cost = tile.width() * tile.height() * std::max(1, tile.depth() / 8);
+    tiles.insert(key, new QPixmap(tile), cost);
+}
+
+void MyTileCache::clear()
+{
+    tiles.clear();
+}
+
+// ----- COUNTERS ---------------------------------------------------------------------------------
+quint64 MyTileCache::getHits()
+{
+    return hits;
+}
+
+quint64 MyTileCache::getMisses()
+{
+    return misses;
+}
+
+int MyTileCache::getBytesHeld()
+{
+    return tiles.totalCost();
+}
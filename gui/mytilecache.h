@@ -0,0 +1,58 @@
+#ifndef MYTILECACHE_H
+#define MYTILECACHE_H
+
+#include <algorithm>
+
+#include <QCache>
+#include <QHash>
+#include <QPixmap>
+
+// ----- TILE KEY -----
+struct MyTileKey
+{
+    quint64 imageVersion; // MyImage::getImageVersion() of the source
+    quint64 lookupVersion; // 0 when the tile shows the source pixels unchanged
+    quint8 level; // pyramid level
+    quint32 col; // tile column within the level
+    quint32 row; // tile row within the level
+
+    bool operator==(const MyTileKey &other) const
+    {
+        return imageVersion == other.imageVersion && lookupVersion == other.lookupVersion &&
+               level == other.level && col == other.col && row == other.row;
+    }
+};
+
+inline uint qHash(const MyTileKey &key, uint seed = 0)
+{
+    return qHash(key.imageVersion, seed) ^ qHash(key.lookupVersion, seed) ^
+           qHash((quint64(key.level) << 48) ^ (quint64(key.col) << 24) ^ quint64(key.row), seed);
+}
+
+// ----- TILE CACHE -----
+class MyTileCache
+{
+
+public:
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyTileCache(int maxBytes);
+    ~MyTileCache();
+
+    // --- TILE ACCESS ---
+    QPixmap *find(MyTileKey key);
+    void insert(MyTileKey key, QPixmap tile);
+    void clear();
+
+    // --- COUNTERS ---
+    quint64 getHits();
+    quint64 getMisses();
+    int getBytesHeld();
+
+private:
+    QCache<MyTileKey, QPixmap> tiles; // least recently used tiles are evicted first, cost in bytes
+    quint64 hits;
+    quint64 misses;
+
+};
+
+#endif // MYTILECACHE_H
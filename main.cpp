@@ -1,11 +1,28 @@
 #include "mainwindow.h"
+#include "mybufferpool.h"
+#include "mycli.h"
 #include <QApplication>
 
 int main(int argc, char* argv[])
 {
+    MyBufferPool::install();
+
+    if(MyCli::isCommandLine(argc, argv))
+    {
+        QCoreApplication MyApplication(argc, argv);
+        MyCli MyCommandLine;
+        return MyCommandLine.run(MyApplication.arguments());
+    }
+
+    // covers QApplication and the window up to the first paint, see MainWindow::reportStartup
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+#ifdef IMAGING_BASICS_EMBEDDED_SAMPLES
     Q_INIT_RESOURCE(images);
+#endif
     QApplication MyApplication(argc, argv);
-    MainWindow MyMainWindow;
+    MainWindow MyMainWindow(0, startupTimer);
     MyMainWindow.show();
     return MyApplication.exec();
 }
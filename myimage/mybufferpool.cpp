@@ -0,0 +1,260 @@
+#include "mybufferpool.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static const size_t pageSize = 4096;
+static const size_t hugePageSize = 2 << 20;
+static const size_t minimumPooled = 16 * pageSize;
+
+// ----- INSTANCE ---------------------------------------------------------------------------------
+MyBufferPool::MyBufferPool() :
+    hits(0),
+    misses(0),
+    bytesHeld(0),
+    bytesInUse(0),
+    maximumBytesHeld((uint64_t)512 << 20),
+    hugePages(false)
+{
+    const char *requested = getenv("IMAGING_BASICS_HUGEPAGES");
+    hugePages = requested && strcmp(requested, "1") == 0;
+}
+
+MyBufferPool *MyBufferPool::getInstance()
+{
+    // never deleted, cv::Mat objects with static storage may still hand blocks back after main
+    static MyBufferPool *pool = new MyBufferPool();
+    return pool;
+}
+
+void MyBufferPool::install()
+{
+    static bool installed = (cv::Mat::setDefaultAllocator(getInstance()), true);
+    (void)installed;
+}
+
+// ----- SETTINGS ---------------------------------------------------------------------------------
+void MyBufferPool::setHugePages(bool enabled)
+{
+    hugePages = enabled;
+}
+
+void MyBufferPool::setMaximumBytesHeld(uint64_t bytes)
+{
+    QMutexLocker locker(&mutex);
+    maximumBytesHeld = bytes;
+}
+
+void MyBufferPool::trim()
+{
+    QMutexLocker locker(&mutex);
+
+    foreach(const QVector<void *> &blocks, freeBlocks)
+    {
+        foreach(void *block, blocks)
+        {
+            freeBlock(block);
+        }
+    }
+    freeBlocks.clear();
+    bytesHeld = 0;
+}
+
+// ----- COUNTERS ---------------------------------------------------------------------------------
+uint64_t MyBufferPool::getHits()
+{
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+uint64_t MyBufferPool::getMisses()
+{
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+uint64_t MyBufferPool::getBytesHeld()
+{
+    QMutexLocker locker(&mutex);
+    return bytesHeld;
+}
+
+uint64_t MyBufferPool::getBytesInUse()
+{
+    QMutexLocker locker(&mutex);
+    return bytesInUse;
+}
+
+// ----- MAT ALLOCATOR ----------------------------------------------------------------------------
+cv::UMatData *MyBufferPool::allocate(int dims, const int *sizes, int type, void *data, size_t *step, AccessFlags flags, cv::UMatUsageFlags usageFlags) const
+{
+    (void)flags;
+    (void)usageFlags;
+
+    // same step layout as the standard allocator, user supplied steps are kept
+    size_t total = CV_ELEM_SIZE(type);
+    for(int i=dims-1; i>=0; i--)
+    {
+        if(step)
+        {
+            if(data && step[i] != CV_AUTOSTEP)
+            {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            }
+            else
+            {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    cv::UMatData *u = new cv::UMatData(this);
+    u->size = total;
+
+    if(data)
+    {
+        u->data = u->origdata = (uchar *)data;
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    }
+    else if(total < minimumPooled)
+    {
+        u->data = u->origdata = (uchar *)cv::fastMalloc(total);
+    }
+    else
+    {
+        u->data = u->origdata = (uchar *)takeBlock(getClassSize(total));
+    }
+    return u;
+}
+
+bool MyBufferPool::allocate(cv::UMatData *data, AccessFlags accessFlags, cv::UMatUsageFlags usageFlags) const
+{
+    (void)accessFlags;
+    (void)usageFlags;
+    return data != 0;
+}
+
+void MyBufferPool::deallocate(cv::UMatData *data) const
+{
+    if(!data)
+    {
+        return;
+    }
+    CV_Assert(data->urefcount == 0);
+    CV_Assert(data->refcount == 0);
+
+    if(!(data->flags & cv::UMatData::USER_ALLOCATED))
+    {
+        if(data->size < minimumPooled)
+        {
+            cv::fastFree(data->origdata);
+        }
+        else
+        {
+            giveBlock(data->origdata, getClassSize(data->size));
+        }
+        data->origdata = 0;
+    }
+    delete data;
+}
+
+// ----- BLOCKS -----------------------------------------------------------------------------------
+size_t MyBufferPool::getClassSize(size_t bytes)
+{
+    // four classes per power of two, so at most a quarter of a block is unused, every class is a
+    // whole number of pages
+    size_t octave = minimumPooled;
+    while(octave <= bytes / 2)
+    {
+        octave *= 2;
+    }
+    size_t increment = octave / 4;
+    return (bytes + increment - 1) / increment * increment;
+}
+
+void *MyBufferPool::takeBlock(size_t classSize) const
+{
+    {
+        QMutexLocker locker(&mutex);
+        bytesInUse += classSize;
+
+        QHash<size_t, QVector<void *> >::iterator blocks = freeBlocks.find(classSize);
+        if(blocks != freeBlocks.end() && !blocks->isEmpty())
+        {
+            void *block = blocks->last();
+            blocks->removeLast();
+            bytesHeld -= classSize;
+            hits++;
+            return block;
+        }
+        misses++;
+    }
+
+    // the system allocation happens outside the lock
+    void *block = allocateBlock(classSize);
+    if(!block)
+    {
+        QMutexLocker locker(&mutex);
+        bytesInUse -= classSize;
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void MyBufferPool::giveBlock(void *block, size_t classSize) const
+{
+    {
+        QMutexLocker locker(&mutex);
+        bytesInUse -= classSize;
+
+        if(bytesHeld + classSize <= maximumBytesHeld)
+        {
+            freeBlocks[classSize].append(block);
+            bytesHeld += classSize;
+            return;
+        }
+    }
+    freeBlock(block);
+}
+
+void *MyBufferPool::allocateBlock(size_t classSize) const
+{
+    bool huge = hugePages && classSize >= hugePageSize;
+    size_t alignment = huge ? hugePageSize : pageSize;
+
+#if defined(_WIN32)
+    return _aligned_malloc(classSize, alignment);
+#else
+    void *block = 0;
+    if(posix_memalign(&block, alignment, classSize) != 0)
+    {
+        return 0;
+    }
+#ifdef MADV_HUGEPAGE
+    if(huge)
+    {
+        // only a hint, the kernel falls back to normal pages when none are free
+        madvise(block, classSize, MADV_HUGEPAGE);
+    }
+#endif
+    return block;
+#endif
+}
+
+void MyBufferPool::freeBlock(void *block) const
+{
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef MYBUFFERPOOL_H
+#define MYBUFFERPOOL_H
+
+#include <atomic>
+#include <stdint.h>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <opencv2/core/core.hpp>
+
+// ----- BUFFER POOL -----
+// page aligned pixel storage for every cv::Mat of the process, freed blocks are kept per size
+// class and handed out again, so repeated operations on images of the same size stop reaching
+// the system allocator; blocks below one size class go straight to cv::fastMalloc
+// IMAGING_BASICS_HUGEPAGES=1 asks the kernel to back blocks of 2 MiB and more with huge pages
+class MyBufferPool : public cv::MatAllocator
+{
+
+public:
+    // --- INSTANCE ---
+    static MyBufferPool *getInstance();
+    static void install(); // makes the pool the default cv::Mat allocator, safe to call again;
+                           // only the applications call it, hosts of the library keep their own
+
+    // --- SETTINGS ---
+    void setHugePages(bool enabled);
+    void setMaximumBytesHeld(uint64_t bytes); // free blocks above this are returned to the system
+    void trim();
+
+    // --- COUNTERS ---
+    uint64_t getHits();
+    uint64_t getMisses();
+    uint64_t getBytesHeld();
+    uint64_t getBytesInUse();
+
+    // --- MAT ALLOCATOR ---
+#if CV_VERSION_MAJOR >= 4
+    typedef cv::AccessFlag AccessFlags; // OpenCV 4 made the access flags an enum
+#else
+    typedef int AccessFlags;
+#endif
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, AccessFlags flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData *data, AccessFlags accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData *data) const override;
+
+private:
+    MyBufferPool();
+
+    static size_t getClassSize(size_t bytes);
+    void *takeBlock(size_t classSize) const;
+    void giveBlock(void *block, size_t classSize) const;
+    void *allocateBlock(size_t classSize) const;
+    void freeBlock(void *block) const;
+
+    // the cv::MatAllocator interface is const, the pool state is not
+    mutable QMutex mutex;
+    mutable QHash<size_t, QVector<void *> > freeBlocks;
+    mutable uint64_t hits;
+    mutable uint64_t misses;
+    mutable uint64_t bytesHeld;
+    mutable uint64_t bytesInUse;
+    uint64_t maximumBytesHeld;
+    std::atomic<bool> hugePages; // read by allocateBlock without the mutex
+};
+
+#endif // MYBUFFERPOOL_H
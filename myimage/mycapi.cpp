@@ -0,0 +1,266 @@
+#include "mycapi.h"
+
+#include <exception>
+#include <string>
+
+#include "mydispatch.h"
+#include "myimage.h"
+#include "myoperation.h"
+
+// ----- OPAQUE TYPES -----------------------------------------------------------------------------
+struct myimage_context
+{
+    std::string error; // what the last call on this context failed with
+};
+
+struct myimage_chain
+{
+    QList<MyOperation> operations;
+    bool needsDistribution;
+    uchar lookup[MyImage::numberBins]; // whole chain, only valid without histogram based steps
+};
+
+// ----- HELPERS ----------------------------------------------------------------------------------
+static int getMatrixType(int format)
+{
+    switch (format){
+    case MYIMAGE_U8:
+        return CV_8UC1;
+    case MYIMAGE_U16:
+        return CV_16UC1;
+    case MYIMAGE_F32:
+        return CV_32FC1;
+    default:
+        return -1;
+    }
+}
+
+static int fail(myimage_context *context, int status, std::string message)
+{
+    context->error = message;
+    return status;
+}
+
+static int checkBuffer(myimage_context *context, const void *pixels, size_t stride, int rows, int cols, int format)
+{
+    int type = getMatrixType(format);
+    if(type < 0)
+    {
+        return fail(context, MYIMAGE_UNSUPPORTED_FORMAT, "unknown pixel format");
+    }
+
+    size_t pixelSize = CV_ELEM_SIZE(type);
+    if(!pixels || rows <= 0 || cols <= 0 || stride < (size_t)cols * pixelSize || stride % pixelSize != 0)
+    {
+        return fail(context, MYIMAGE_INVALID_ARGUMENT, "invalid buffer, size or stride");
+    }
+    return MYIMAGE_OK;
+}
+
+static bool isOverlapping(const void *source, size_t sourceStride, const void *target, size_t targetStride, int rows)
+{
+    const uchar *sourceEnd = (const uchar *)source + sourceStride * rows;
+    const uchar *targetEnd = (const uchar *)target + targetStride * rows;
+    return (const uchar *)source < targetEnd && (const uchar *)target < sourceEnd;
+}
+
+static void countRows(const cv::Mat &source, uint64_t *bins)
+{
+    const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
+
+    for(int row=0; row < source.rows; row++)
+    {
+        kernels.countHistogram(source.ptr<uchar>(row), source.cols, bins);
+    }
+}
+
+// ----- LIBRARY ----------------------------------------------------------------------------------
+int myimage_abi_version(void)
+{
+    return MYIMAGE_ABI_VERSION;
+}
+
+// ----- CONTEXTS ---------------------------------------------------------------------------------
+myimage_context *myimage_context_create(void)
+{
+    try
+    {
+        return new myimage_context();
+    }
+    catch(const std::exception &)
+    {
+        return 0;
+    }
+}
+
+void myimage_context_destroy(myimage_context *context)
+{
+    delete context;
+}
+
+const char *myimage_context_error(const myimage_context *context)
+{
+    return context ? context->error.c_str() : "no context";
+}
+
+// ----- CHAINS -----------------------------------------------------------------------------------
+myimage_chain *myimage_chain_compile(const char *chain)
+{
+    if(!chain)
+    {
+        return 0;
+    }
+
+    try
+    {
+        bool ok = false;
+        QList<MyOperation> operations = MyOperation::parseChain(QString::fromUtf8(chain), &ok);
+        if(!ok)
+        {
+            return 0;
+        }
+
+        myimage_chain *compiled = new myimage_chain();
+        compiled->operations = operations;
+        compiled->needsDistribution = MyOperation::needsDistribution(operations);
+
+        // without equalization or auto contrast the tables do not depend on the pixels, so 8 bit buffers only
+        // need the single lookup pass at process time
+        QVector<double> empty(MyImage::numberBins, 0);
+        MyOperation::buildChainLookup(operations, empty, compiled->lookup);
+        return compiled;
+    }
+    catch(const std::exception &)
+    {
+        return 0;
+    }
+}
+
+void myimage_chain_destroy(myimage_chain *chain)
+{
+    delete chain;
+}
+
+// ----- PROCESSING -------------------------------------------------------------------------------
+int myimage_process(myimage_context *context, const myimage_chain *chain,
+                    const void *source, size_t sourceStride,
+                    void *target, size_t targetStride,
+                    int rows, int cols, int format)
+{
+    if(!context)
+    {
+        return MYIMAGE_INVALID_ARGUMENT;
+    }
+    context->error.clear();
+
+    if(!chain)
+    {
+        return fail(context, MYIMAGE_INVALID_ARGUMENT, "no chain");
+    }
+
+    int status = checkBuffer(context, source, sourceStride, rows, cols, format);
+    if(status == MYIMAGE_OK)
+    {
+        status = checkBuffer(context, target, targetStride, rows, cols, format);
+    }
+    if(status != MYIMAGE_OK)
+    {
+        return status;
+    }
+
+    if(chain->needsDistribution && format != MYIMAGE_U8)
+    {
+        return fail(context, MYIMAGE_UNSUPPORTED_FORMAT, "equalization and auto contrast need 8 bit pixels");
+    }
+
+    try
+    {
+        int type = getMatrixType(format);
+        cv::Mat sourceMatrix(rows, cols, type, (void *)source, sourceStride);
+        cv::Mat targetMatrix(rows, cols, type, target, targetStride);
+
+        if(format != MYIMAGE_U8)
+        {
+            // wide pixels go step by step through the engine, which detects the in place case
+            MyImage input("input");
+            MyImage output("output");
+            input.setImageFromMatrix(sourceMatrix, false);
+            output.setImageFromMatrix(targetMatrix, false);
+
+            QList<MyOperation> operations = chain->operations;
+            operations[0].processImage(output, input);
+            for(int i=1; i<operations.size(); i++)
+            {
+                operations[i].processImage(output, output);
+            }
+            return MYIMAGE_OK;
+        }
+
+        // a shifted overlap would read rows that are already written
+        bool inPlace = source == target && sourceStride == targetStride;
+        if(!inPlace && isOverlapping(source, sourceStride, target, targetStride, rows))
+        {
+            sourceMatrix = sourceMatrix.clone();
+        }
+
+        uchar lookup[MyImage::numberBins];
+        const uchar *table = chain->lookup;
+
+        if(chain->needsDistribution)
+        {
+            std::vector<uint64_t> counts(MyImage::numberBins, 0);
+            countRows(sourceMatrix, counts.data());
+
+            QVector<double> distribution(MyImage::numberBins, 0);
+            for(uint16_t i=0; i<MyImage::numberBins; i++)
+            {
+                distribution[i] = counts[i];
+            }
+            MyOperation::buildChainLookup(chain->operations, distribution, lookup);
+            table = lookup;
+        }
+
+        const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
+        for(int row=0; row < rows; row++)
+        {
+            kernels.applyLookup(sourceMatrix.ptr<uchar>(row), targetMatrix.ptr<uchar>(row), cols, table);
+        }
+        return MYIMAGE_OK;
+    }
+    catch(const std::exception &exception)
+    {
+        return fail(context, MYIMAGE_FAILED, exception.what());
+    }
+}
+
+int myimage_histogram(myimage_context *context,
+                      const void *source, size_t sourceStride,
+                      int rows, int cols, int format, uint64_t bins[256])
+{
+    if(!context)
+    {
+        return MYIMAGE_INVALID_ARGUMENT;
+    }
+    context->error.clear();
+
+    int status = checkBuffer(context, source, sourceStride, rows, cols, format);
+    if(status != MYIMAGE_OK)
+    {
+        return status;
+    }
+    if(!bins)
+    {
+        return fail(context, MYIMAGE_INVALID_ARGUMENT, "no bins");
+    }
+    if(format != MYIMAGE_U8)
+    {
+        return fail(context, MYIMAGE_UNSUPPORTED_FORMAT, "histograms need 8 bit pixels");
+    }
+
+    for(int i=0; i<MyImage::numberBins; i++)
+    {
+        bins[i] = 0;
+    }
+    countRows(cv::Mat(rows, cols, CV_8UC1, (void *)source, sourceStride), bins);
+    return MYIMAGE_OK;
+}
@@ -0,0 +1,80 @@
+#ifndef MYCAPI_H
+#define MYCAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----- C API -----
+// plain C interface of libmyimage for callers outside of Qt and C++, no Qt or OpenCV type
+// crosses it. pixels stay in caller owned memory, rows are stride bytes apart and source and
+// target may be the same buffer. a context is used by one thread at a time, every thread keeps
+// its own; compiled chains are immutable and may be shared by any number of threads
+//
+//   myimage_context *context = myimage_context_create();
+//   myimage_chain *chain = myimage_chain_compile("negative,power=0.5,equalize");
+//   myimage_process(context, chain, pixels, stride, pixels, stride, rows, cols, MYIMAGE_U8);
+//   myimage_chain_destroy(chain);
+//   myimage_context_destroy(context);
+
+#if defined(_WIN32) && defined(MYIMAGE_BUILD_SHARED)
+#define MYIMAGE_API __declspec(dllexport)
+#elif defined(_WIN32) && defined(MYIMAGE_SHARED)
+#define MYIMAGE_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define MYIMAGE_API __attribute__((visibility("default")))
+#else
+#define MYIMAGE_API
+#endif
+
+#define MYIMAGE_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// --- TYPES ---
+typedef struct myimage_context myimage_context;
+typedef struct myimage_chain myimage_chain;
+
+enum myimage_format
+{
+    MYIMAGE_U8 = 1,
+    MYIMAGE_U16 = 2,
+    MYIMAGE_F32 = 3
+};
+
+enum myimage_status
+{
+    MYIMAGE_OK = 0,
+    MYIMAGE_INVALID_ARGUMENT = -1,
+    MYIMAGE_UNSUPPORTED_FORMAT = -2, // equalization, auto contrast and histograms need MYIMAGE_U8
+    MYIMAGE_FAILED = -3
+};
+
+// --- LIBRARY ---
+MYIMAGE_API int myimage_abi_version(void); // MYIMAGE_ABI_VERSION the library was built with
+
+// --- CONTEXTS ---
+MYIMAGE_API myimage_context *myimage_context_create(void);
+MYIMAGE_API void myimage_context_destroy(myimage_context *context);
+MYIMAGE_API const char *myimage_context_error(const myimage_context *context); // last failure, UTF-8
+
+// --- CHAINS ---
+// "negative,power=0.5,equalize", the same syntax as the command line; NULL when it does not parse
+MYIMAGE_API myimage_chain *myimage_chain_compile(const char *chain);
+MYIMAGE_API void myimage_chain_destroy(myimage_chain *chain);
+
+// --- PROCESSING ---
+MYIMAGE_API int myimage_process(myimage_context *context, const myimage_chain *chain,
+                                const void *source, size_t sourceStride,
+                                void *target, size_t targetStride,
+                                int rows, int cols, int format);
+MYIMAGE_API int myimage_histogram(myimage_context *context,
+                                  const void *source, size_t sourceStride,
+                                  int rows, int cols, int format, uint64_t bins[256]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MYCAPI_H
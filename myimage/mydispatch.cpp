@@ -0,0 +1,314 @@
+#include "mydispatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MYDISPATCH_X86
+#define MYDISPATCH_SSE2 __attribute__((target("sse2")))
+#define MYDISPATCH_AVX2 __attribute__((target("avx2")))
+#define MYDISPATCH_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define MYDISPATCH_AVX512VBMI __attribute__((target("avx512f,avx512bw,avx512vbmi")))
+#endif
+
+// ----- SCALAR -----------------------------------------------------------------------------------
+static void scalarApplyLookup(const uint8_t *source, uint8_t *target, size_t count, const uint8_t *lookup)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        target[i] = lookup[source[i]];
+    }
+}
+
+static void scalarCountHistogram(const uint8_t *source, size_t count, uint64_t *bins)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        bins[source[i]]++;
+    }
+}
+
+static void scalarConvert16U(const uint16_t *source, float *target, size_t count, float scale)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        target[i] = scale * source[i];
+    }
+}
+
+static void scalarConvert32F(const float *source, float *target, size_t count, float scale)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        target[i] = scale * source[i];
+    }
+}
+
+static void bankedCountHistogram(const uint8_t *source, size_t count, uint64_t *bins)
+{
+    // four interleaved tables, so runs of equal pixels do not serialize on a single counter
+    if(count < 1024)
+    {
+        scalarCountHistogram(source, count, bins);
+        return;
+    }
+
+    uint32_t bank[4][256];
+    while(count > 0)
+    {
+        size_t chunk = std::min<size_t>(count, (size_t)1 << 30);
+        memset(bank, 0, sizeof(bank));
+
+        size_t i = 0;
+        for(; i + 4 <= chunk; i += 4)
+        {
+            bank[0][source[i]]++;
+            bank[1][source[i + 1]]++;
+            bank[2][source[i + 2]]++;
+            bank[3][source[i + 3]]++;
+        }
+        for(; i < chunk; i++)
+        {
+            bank[0][source[i]]++;
+        }
+
+        for(int bin=0; bin<256; bin++)
+        {
+            bins[bin] += (uint64_t)bank[0][bin] + bank[1][bin] + bank[2][bin] + bank[3][bin];
+        }
+        source += chunk;
+        count -= chunk;
+    }
+}
+
+#ifdef MYDISPATCH_X86
+// ----- SSE2 -------------------------------------------------------------------------------------
+static MYDISPATCH_SSE2 void sse2Convert16U(const uint16_t *source, float *target, size_t count, float scale)
+{
+    __m128 factor = _mm_set1_ps(scale);
+    __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(source + i));
+        _mm_storeu_ps(target + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(pixels, zero)), factor));
+        _mm_storeu_ps(target + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(pixels, zero)), factor));
+    }
+    scalarConvert16U(source + i, target + i, count - i, scale);
+}
+
+static MYDISPATCH_SSE2 void sse2Convert32F(const float *source, float *target, size_t count, float scale)
+{
+    __m128 factor = _mm_set1_ps(scale);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(target + i, _mm_mul_ps(_mm_loadu_ps(source + i), factor));
+    }
+    scalarConvert32F(source + i, target + i, count - i, scale);
+}
+
+// ----- AVX2 -------------------------------------------------------------------------------------
+static MYDISPATCH_AVX2 void avx2Convert16U(const uint16_t *source, float *target, size_t count, float scale)
+{
+    __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(source + i)));
+        _mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_cvtepi32_ps(pixels), factor));
+    }
+    scalarConvert16U(source + i, target + i, count - i, scale);
+}
+
+static MYDISPATCH_AVX2 void avx2Convert32F(const float *source, float *target, size_t count, float scale)
+{
+    __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_loadu_ps(source + i), factor));
+    }
+    scalarConvert32F(source + i, target + i, count - i, scale);
+}
+
+// ----- AVX-512 ----------------------------------------------------------------------------------
+static MYDISPATCH_AVX512VBMI void avx512VbmiApplyLookup(const uint8_t *source, uint8_t *target, size_t count, const uint8_t *lookup)
+{
+    // two 128 entry permutes cover the table, the top bit of the pixel picks between them
+    __m512i table0 = _mm512_loadu_si512(lookup);
+    __m512i table1 = _mm512_loadu_si512(lookup + 64);
+    __m512i table2 = _mm512_loadu_si512(lookup + 128);
+    __m512i table3 = _mm512_loadu_si512(lookup + 192);
+
+    size_t i = 0;
+    for(; i + 64 <= count; i += 64)
+    {
+        __m512i pixels = _mm512_loadu_si512(source + i);
+        __m512i low = _mm512_permutex2var_epi8(table0, pixels, table1);
+        __m512i high = _mm512_permutex2var_epi8(table2, pixels, table3);
+        _mm512_storeu_si512(target + i, _mm512_mask_blend_epi8(_mm512_movepi8_mask(pixels), low, high));
+    }
+    scalarApplyLookup(source + i, target + i, count - i, lookup);
+}
+
+static MYDISPATCH_AVX512 void avx512ApplyLookup(const uint8_t *source, uint8_t *target, size_t count, const uint8_t *lookup)
+{
+    // without VBMI the table is split in sixteen rows of sixteen, pshufb looks up the low nibble
+    // in every row and the high nibble selects which row is kept
+    __m512i rows[16];
+    for(int k=0; k<16; k++)
+    {
+        uint8_t repeated[64];
+        for(int lane=0; lane<4; lane++)
+        {
+            memcpy(repeated + 16 * lane, lookup + 16 * k, 16);
+        }
+        rows[k] = _mm512_loadu_si512(repeated);
+    }
+
+    __m512i nibble = _mm512_set1_epi8(0x0f);
+    size_t i = 0;
+    for(; i + 64 <= count; i += 64)
+    {
+        __m512i pixels = _mm512_loadu_si512(source + i);
+        __m512i column = _mm512_and_si512(pixels, nibble);
+        __m512i row = _mm512_and_si512(_mm512_srli_epi16(pixels, 4), nibble);
+        __m512i result = _mm512_setzero_si512();
+
+        for(int k=0; k<16; k++)
+        {
+            __mmask64 selected = _mm512_cmpeq_epi8_mask(row, _mm512_set1_epi8(k));
+            result = _mm512_mask_shuffle_epi8(result, selected, rows[k], column);
+        }
+        _mm512_storeu_si512(target + i, result);
+    }
+    scalarApplyLookup(source + i, target + i, count - i, lookup);
+}
+
+static MYDISPATCH_AVX512 void avx512Convert16U(const uint16_t *source, float *target, size_t count, float scale)
+{
+    __m512 factor = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        // the zero masked forms, the plain ones start from _mm512_undefined and g++ 12 reports
+        // them as maybe uninitialized
+        __m512i pixels = _mm512_maskz_cvtepu16_epi32(0xFFFF, _mm256_loadu_si256((const __m256i *)(source + i)));
+        _mm512_storeu_ps(target + i, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(0xFFFF, pixels), factor));
+    }
+    scalarConvert16U(source + i, target + i, count - i, scale);
+}
+
+static MYDISPATCH_AVX512 void avx512Convert32F(const float *source, float *target, size_t count, float scale)
+{
+    __m512 factor = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        _mm512_storeu_ps(target + i, _mm512_mul_ps(_mm512_loadu_ps(source + i), factor));
+    }
+    scalarConvert32F(source + i, target + i, count - i, scale);
+}
+#endif
+
+// ----- LEVELS -----------------------------------------------------------------------------------
+static MyDispatch::Level detectLevel()
+{
+#ifdef MYDISPATCH_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+        return MyDispatch::AVX512;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return MyDispatch::AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1"))
+    {
+        return MyDispatch::SSE41;
+    }
+    if(__builtin_cpu_supports("sse2"))
+    {
+        return MyDispatch::SSE2;
+    }
+#endif
+    return MyDispatch::Scalar;
+}
+
+static MyDispatch::Level selectLevel()
+{
+    MyDispatch::Level level = MyDispatch::getDetectedLevel();
+    const char *requested = getenv("IMAGING_BASICS_SIMD");
+
+    if(requested)
+    {
+        for(int candidate=MyDispatch::Scalar; candidate<=MyDispatch::AVX512; candidate++)
+        {
+            if(std::string(requested) == MyDispatch::getLevelName((MyDispatch::Level)candidate))
+            {
+                level = std::min(level, (MyDispatch::Level)candidate);
+            }
+        }
+    }
+    return level;
+}
+
+MyDispatch::Level MyDispatch::getDetectedLevel()
+{
+    static const Level detected = detectLevel();
+    return detected;
+}
+
+MyDispatch::Level MyDispatch::getLevel()
+{
+    static const Level level = selectLevel();
+    return level;
+}
+
+const char *MyDispatch::getLevelName(Level level)
+{
+    static const char *names[] = { "scalar", "sse2", "sse41", "avx2", "avx512" };
+    return names[level];
+}
+
+// ----- KERNELS ----------------------------------------------------------------------------------
+static MyDispatch::Kernels bindKernels(MyDispatch::Level level)
+{
+    // each level only replaces the kernels that measured faster than the level below it, a
+    // pshufb lookup over sixteen rows loses to the scalar table below AVX-512, so SSE4.1 adds
+    // nothing yet and is kept as a level for the override
+    MyDispatch::Kernels kernels = { scalarApplyLookup, scalarCountHistogram, scalarConvert16U, scalarConvert32F };
+#ifdef MYDISPATCH_X86
+    if(level >= MyDispatch::SSE2)
+    {
+        kernels.countHistogram = bankedCountHistogram;
+        kernels.convert16U = sse2Convert16U;
+        kernels.convert32F = sse2Convert32F;
+    }
+    if(level >= MyDispatch::AVX2)
+    {
+        kernels.convert16U = avx2Convert16U;
+        kernels.convert32F = avx2Convert32F;
+    }
+    if(level >= MyDispatch::AVX512)
+    {
+        kernels.applyLookup = __builtin_cpu_supports("avx512vbmi") ? avx512VbmiApplyLookup : avx512ApplyLookup;
+        kernels.convert16U = avx512Convert16U;
+        kernels.convert32F = avx512Convert32F;
+    }
+#else
+    (void)level;
+#endif
+    return kernels;
+}
+
+const MyDispatch::Kernels &MyDispatch::getKernels()
+{
+    static const Kernels kernels = bindKernels(getLevel());
+    return kernels;
+}
@@ -0,0 +1,32 @@
+#ifndef MYDISPATCH_H
+#define MYDISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----- CPU DISPATCH -----
+// the pixel kernels are compiled for every instruction set level and bound once at startup to
+// the widest one the processor supports, IMAGING_BASICS_SIMD=scalar|sse2|sse41|avx2|avx512
+// caps the level for testing; the cap never raises it above what was detected
+namespace MyDispatch
+{
+    // --- LEVELS ---
+    enum Level { Scalar, SSE2, SSE41, AVX2, AVX512 };
+
+    Level getLevel();
+    Level getDetectedLevel();
+    const char *getLevelName(Level level);
+
+    // --- KERNELS ---
+    struct Kernels
+    {
+        void (*applyLookup)(const uint8_t *source, uint8_t *target, size_t count, const uint8_t *lookup);
+        void (*countHistogram)(const uint8_t *source, size_t count, uint64_t *bins); // adds to 256 bins
+        void (*convert16U)(const uint16_t *source, float *target, size_t count, float scale);
+        void (*convert32F)(const float *source, float *target, size_t count, float scale);
+    };
+
+    const Kernels &getKernels();
+}
+
+#endif // MYDISPATCH_H
@@ -0,0 +1,21 @@
+# links libmyimage from myimage.pro instead of compiling its sources into the target, for the
+# projects one directory below ImagingBasics.pro
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+MYIMAGE_BUILD = $$OUT_PWD/../myimage
+
+win32 {
+    CONFIG(debug, debug|release): MYIMAGE_BUILD = $$MYIMAGE_BUILD/debug
+    else: MYIMAGE_BUILD = $$MYIMAGE_BUILD/release
+}
+
+LIBS += -L$$MYIMAGE_BUILD -lmyimage -ltiff
+
+!myimage_shared {
+    win32-msvc*: PRE_TARGETDEPS += $$MYIMAGE_BUILD/myimage.lib
+    else: PRE_TARGETDEPS += $$MYIMAGE_BUILD/libmyimage.a
+}
+
+include(../opencv.pri)
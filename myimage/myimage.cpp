@@ -1,9 +1,331 @@
 #include "myimage.h"
 
+static std::atomic<uint64_t> nextImageVersion(1);
+
+// ----- ADAPTIVE EQUALIZATION KERNELS ------------------------------------------------------------
+// clipped histogram equalization of one tile per loop index, the result is one lookup per tile
+class MyTileLookupBody : public cv::ParallelLoopBody
+{
+public:
+    MyTileLookupBody(const cv::Mat &input, int rows, int cols, double limit, std::vector<uchar> &output) :
+        source(input), gridRows(rows), gridCols(cols), clipLimit(limit), lookups(output)
+    {
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        const int bins = MyImage::numberBins;
+
+        for(int tile=range.start; tile<range.end; tile++)
+        {
+            int top = (tile / gridCols) * source.rows / gridRows;
+            int bottom = (tile / gridCols + 1) * source.rows / gridRows;
+            int left = (tile % gridCols) * source.cols / gridCols;
+            int right = (tile % gridCols + 1) * source.cols / gridCols;
+
+            uint32_t histogram[bins] = {0};
+            for(int row=top; row<bottom; row++)
+            {
+                const uchar *pixel = source.ptr<uchar>(row);
+                for(int col=left; col<right; col++)
+                {
+                    histogram[pixel[col]]++;
+                }
+            }
+
+            // clip every bin at the limit and hand the excess back to all bins evenly
+            uint64_t pixels = std::max(1, (bottom - top) * (right - left));
+            uint32_t limit = std::max<uint32_t>(1, clipLimit * pixels / bins);
+            uint64_t excess = 0;
+
+            for(int i=0; i<bins; i++)
+            {
+                if(histogram[i] > limit)
+                {
+                    excess = excess + histogram[i] - limit;
+                    histogram[i] = limit;
+                }
+            }
+
+            uint32_t share = excess / bins;
+            uint32_t residual = excess % bins;
+            for(int i=0; i<bins; i++)
+            {
+                histogram[i] = histogram[i] + share;
+            }
+            for(uint32_t i=0; i<residual; i++)
+            {
+                histogram[i * bins / residual]++;
+            }
+
+            uchar *lookup = &lookups[tile * bins];
+            uint64_t cdf = 0;
+            for(int i=0; i<bins; i++)
+            {
+                cdf = cdf + histogram[i];
+                lookup[i] = std::min<uint64_t>(MyImage::maxBin, (cdf * MyImage::maxBin + pixels / 2) / pixels);
+            }
+        }
+    }
+
+private:
+    const cv::Mat &source;
+    int gridRows;
+    int gridCols;
+    double clipLimit;
+    std::vector<uchar> &lookups;
+};
+
+// bilinear blend of the four nearest tile lookups in 8 bit fixed point, one loop index per row
+class MyTileInterpolationBody : public cv::ParallelLoopBody
+{
+public:
+    MyTileInterpolationBody(const cv::Mat &input, cv::Mat &output, const cv::Mat &allowed,
+                            const std::vector<uchar> &tables, int cols,
+                            const std::vector<int> &rowsTile, const std::vector<int> &rowsWeight,
+                            const std::vector<int> &colsTile, const std::vector<int> &colsWeight) :
+        source(input), target(output), mask(allowed), lookups(tables), gridCols(cols),
+        rowTile(rowsTile), rowWeight(rowsWeight), colTile(colsTile), colWeight(colsWeight)
+    {
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        const int bins = MyImage::numberBins;
+        const int stride = gridCols * bins;
+
+        for(int row=range.start; row<range.end; row++)
+        {
+            const uchar *pixel = source.ptr<uchar>(row);
+            const uchar *allowed = mask.empty() ? 0 : mask.ptr<uchar>(row);
+            uchar *result = target.ptr<uchar>(row);
+
+            // the lower tile row is the next one, or the same one at the border where the weight is 0
+            const uchar *upper = &lookups[rowTile[row] * stride];
+            const uchar *lower = upper + (rowWeight[row] ? stride : 0);
+            int wy = rowWeight[row];
+
+            for(int col=0; col<source.cols; col++)
+            {
+                int offset = colTile[col] * bins + pixel[col];
+                int next = colWeight[col] ? bins : 0;
+                int wx = colWeight[col];
+
+                int top = upper[offset] * (256 - wx) + upper[offset + next] * wx;
+                int bottom = lower[offset] * (256 - wx) + lower[offset + next] * wx;
+                int value = (top * (256 - wy) + bottom * wy + (1 << 15)) >> 16;
+
+                if(!allowed || allowed[col])
+                {
+                    result[col] = value;
+                }
+            }
+        }
+    }
+
+private:
+    const cv::Mat &source;
+    cv::Mat &target;
+    const cv::Mat &mask;
+    const std::vector<uchar> &lookups;
+    int gridCols;
+    const std::vector<int> &rowTile;
+    const std::vector<int> &rowWeight;
+    const std::vector<int> &colTile;
+    const std::vector<int> &colWeight;
+};
+
+// ----- LOCAL EQUALIZATION KERNEL ----------------------------------------------------------------
+// sliding window histogram equalization after Perreault and Hebert: one histogram per column
+// covers the window rows, the window histogram moves along the row by adding and removing whole
+// column histograms, and a 16 bin coarse level keeps the rank query short. Fine segments are only
+// brought up to date when a pixel needs them, so every pixel costs a constant number of steps.
+class MyLocalEqualizeBody : public cv::ParallelLoopBody
+{
+public:
+    MyLocalEqualizeBody(const cv::Mat &input, cv::Mat &output, const cv::Mat &allowed, int size, int bands) :
+        source(input), target(output), mask(allowed), radius(size), bandCount(bands)
+    {
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        for(int band=range.start; band<range.end; band++)
+        {
+            processBand(band * source.rows / bandCount, (band + 1) * source.rows / bandCount);
+        }
+    }
+
+private:
+    static const int fineBins = 256;
+    static const int coarseBins = 16;
+    static const int segmentBins = fineBins / coarseBins;
+
+    void updateColumns(std::vector<uint16_t> &columnFine, std::vector<uint16_t> &columnCoarse, int row, int sign) const
+    {
+        const uchar *pixel = source.ptr<uchar>(row);
+        for(int col=0; col<source.cols; col++)
+        {
+            columnFine[col * fineBins + pixel[col]] += sign;
+            columnCoarse[col * coarseBins + (pixel[col] >> 4)] += sign;
+        }
+    }
+
+    void processBand(int firstRow, int lastRow) const
+    {
+        const int cols = source.cols;
+        const int rows = source.rows;
+
+        std::vector<uint16_t> columnFine(cols * fineBins, 0);
+        std::vector<uint16_t> columnCoarse(cols * coarseBins, 0);
+
+        // column histograms start out covering the window of the first row of the band
+        for(int row=std::max(0, firstRow - radius); row<=std::min(rows - 1, firstRow + radius); row++)
+        {
+            updateColumns(columnFine, columnCoarse, row, 1);
+        }
+
+        for(int row=firstRow; row<lastRow; row++)
+        {
+            if(row > firstRow)
+            {
+                if(row - radius - 1 >= 0)
+                {
+                    updateColumns(columnFine, columnCoarse, row - radius - 1, -1);
+                }
+                if(row + radius < rows)
+                {
+                    updateColumns(columnFine, columnCoarse, row + radius, 1);
+                }
+            }
+
+            uint32_t kernelCoarse[coarseBins] = {0};
+            uint32_t kernelFine[fineBins] = {0};
+            int segmentColumn[coarseBins]; // column the fine segment was last brought up to date for
+            std::fill(segmentColumn, segmentColumn + coarseBins, -1);
+
+            for(int col=0; col<=std::min(cols - 1, radius); col++)
+            {
+                for(int i=0; i<coarseBins; i++)
+                {
+                    kernelCoarse[i] += columnCoarse[col * coarseBins + i];
+                }
+            }
+
+            const uchar *pixel = source.ptr<uchar>(row);
+            const uchar *allowed = mask.empty() ? 0 : mask.ptr<uchar>(row);
+            uchar *result = target.ptr<uchar>(row);
+            uint32_t windowRows = std::min(rows - 1, row + radius) - std::max(0, row - radius) + 1;
+
+            for(int col=0; col<cols; col++)
+            {
+                if(col > 0)
+                {
+                    int added = col + radius;
+                    int removed = col - radius - 1;
+                    for(int i=0; i<coarseBins; i++)
+                    {
+                        kernelCoarse[i] += (added < cols ? columnCoarse[added * coarseBins + i] : 0) -
+                                           (removed >= 0 ? columnCoarse[removed * coarseBins + i] : 0);
+                    }
+                }
+
+                int first = std::max(0, col - radius);
+                int last = std::min(cols - 1, col + radius);
+                int value = pixel[col];
+                int segment = value >> 4;
+                uint32_t *fine = kernelFine + segment * segmentBins;
+
+                if(segmentColumn[segment] < 0 || col - segmentColumn[segment] > 2 * radius + 1)
+                {
+                    // stale for longer than a window width, rebuilding is cheaper than catching up
+                    std::fill(fine, fine + segmentBins, 0);
+                    for(int c=first; c<=last; c++)
+                    {
+                        const uint16_t *column = &columnFine[c * fineBins + segment * segmentBins];
+                        for(int i=0; i<segmentBins; i++)
+                        {
+                            fine[i] += column[i];
+                        }
+                    }
+                }
+                else
+                {
+                    for(int step=segmentColumn[segment] + 1; step<=col; step++)
+                    {
+                        int added = step + radius;
+                        int removed = step - radius - 1;
+                        if(added < cols)
+                        {
+                            const uint16_t *column = &columnFine[added * fineBins + segment * segmentBins];
+                            for(int i=0; i<segmentBins; i++)
+                            {
+                                fine[i] += column[i];
+                            }
+                        }
+                        if(removed >= 0)
+                        {
+                            const uint16_t *column = &columnFine[removed * fineBins + segment * segmentBins];
+                            for(int i=0; i<segmentBins; i++)
+                            {
+                                fine[i] -= column[i];
+                            }
+                        }
+                    }
+                }
+                segmentColumn[segment] = col;
+
+                // rank of the center pixel within its window
+                uint64_t rank = 0;
+                for(int i=0; i<segment; i++)
+                {
+                    rank += kernelCoarse[i];
+                }
+                for(int i=0; i<=(value & (segmentBins - 1)); i++)
+                {
+                    rank += fine[i];
+                }
+
+                uint64_t count = (uint64_t)windowRows * (last - first + 1);
+                if(!allowed || allowed[col])
+                {
+                    result[col] = (rank * MyImage::maxBin + count / 2) / count;
+                }
+            }
+        }
+    }
+
+    const cv::Mat &source;
+    cv::Mat &target;
+    const cv::Mat &mask;
+    int radius;
+    int bandCount;
+};
+
+// tile index left of / above each coordinate and the weight of the next tile in 1/256
+static void buildTileWeights(int length, int grid, std::vector<int> &tile, std::vector<int> &weight)
+{
+    tile.resize(length);
+    weight.resize(length);
+
+    for(int i=0; i<length; i++)
+    {
+        double position = (i + 0.5) * grid / length - 0.5; // in tile units, tile centers at integers
+        int index = std::max(0, std::min(grid - 1, (int)floor(position)));
+        double fraction = std::max(0.0, std::min(1.0, position - index));
+
+        tile[i] = index;
+        weight[i] = (index == grid - 1) ? 0 : (int)round(fraction * 256);
+    }
+}
+
 // ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
 MyImage::MyImage(QString input)
 {
     setTitle(input);
+    resetPyramid();
+    histogramVersion = 0;
+    wideDistributionVersion = 0;
 }
 
 MyImage::~MyImage()
@@ -14,13 +336,29 @@ MyImage::~MyImage()
 // ----- INITIALIZATION ---------------------------------------------------------------------------
 void MyImage::setImageFromPath(std::string image_path)
 {
-    cv::destroyAllWindows();
     image.release();
 
     image = cv::imread(image_path, intensityColorMap);
+    clearRegionOfInterest();
+    resetPyramid();
     setIntensityHistograms();
 }
 
+void MyImage::setImageFromMatrix(cv::Mat input, bool countHistograms)
+{
+    // the header is adopted, pixels in caller owned memory stay there and are written in place
+    image = input;
+    clearRegionOfInterest();
+    resetPyramid();
+
+    if(countHistograms && image.depth() == CV_8U)
+    {
+        setIntensityHistograms();
+        return;
+    }
+    resetIntensityHistograms();
+}
+
 void MyImage::setImageMatchZero(MyImage input)
 {
     setImageToZero(input.getRows(),input.getCols(),input.getType());
@@ -28,15 +366,21 @@ void MyImage::setImageMatchZero(MyImage input)
 
 void MyImage::setImageToZero(uint32_t rows, uint32_t cols, int type)
 {
-    image.release();
-    image = cv::Mat::zeros(rows, cols, type);
+    // keep the current pixels when the size matches, unless another image still shares them
+    if(image.u && image.u->refcount > 1)
+    {
+        image.release();
+    }
+    image.create(rows, cols, type);
+    image.setTo(0);
+    clearRegionOfInterest();
+    resetPyramid();
     setIntensityHistograms();
 }
 
 void MyImage::setImageToDefault(QString filePath)
 {
     QFile file(filePath);
-    cv::destroyAllWindows();
     image.release();
 
     if(file.open(QIODevice::ReadOnly))
@@ -48,6 +392,30 @@ void MyImage::setImageToDefault(QString filePath)
 
         image = cv::imdecode(buf, intensityColorMap);
     }
+    clearRegionOfInterest();
+    resetPyramid();
+    setIntensityHistograms();
+}
+
+void MyImage::setImageToProxy(MyImage &input, uint32_t maxRows, uint32_t maxCols)
+{
+    double factor = 1.0;
+
+    if(input.getRows() > maxRows)
+    {
+        factor = std::min(factor, 1.0 * maxRows / input.getRows());
+    }
+
+    if(input.getCols() > maxCols)
+    {
+        factor = std::min(factor, 1.0 * maxCols / input.getCols());
+    }
+
+    // reuse the display pyramid of the source, the level is at most twice the requested size
+    image.release();
+    image = input.getPyramidLevel(input.getPyramidLevelForScale(factor));
+    clearRegionOfInterest();
+    resetPyramid();
     setIntensityHistograms();
 }
 
@@ -56,6 +424,101 @@ void MyImage::setTitle(QString input)
     qTitle = input;
 }
 
+// ----- REGION OF INTEREST ----------------------------------------------------------------------
+void MyImage::setRegionOfInterest(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    region = cv::Rect(x, y, width, height) & cv::Rect(0, 0, image.cols, image.rows);
+
+    if(region.empty())
+    {
+        region = cv::Rect();
+    }
+    wideDistributionVersion = 0;
+    setIntensityHistograms();
+}
+
+void MyImage::setRegionMask(cv::Mat mask)
+{
+    regionMask.release();
+
+    if(mask.rows == image.rows && mask.cols == image.cols && mask.type() == CV_8UC1)
+    {
+        regionMask = mask;
+    }
+    wideDistributionVersion = 0;
+    setIntensityHistograms();
+}
+
+void MyImage::clearRegionOfInterest()
+{
+    region = cv::Rect();
+    regionMask.release();
+    wideDistributionVersion = 0;
+}
+
+bool MyImage::hasRegionOfInterest()
+{
+    return !region.empty() || !regionMask.empty();
+}
+
+cv::Mat MyImage::getRegion()
+{
+    // a header into image, no pixels are copied
+    if(region.empty())
+    {
+        return image;
+    }
+    return image(region);
+}
+
+cv::Mat MyImage::getRegionMask()
+{
+    if(regionMask.empty() || region.empty())
+    {
+        return regionMask;
+    }
+    return regionMask(region);
+}
+
+// ----- ALIASING ---------------------------------------------------------------------------------
+bool MyImage::sharesPixelsWith(MyImage &input)
+{
+    // copies of a MyImage share the pixel buffer, so compare the memory and not the objects
+    if(image.empty() || input.image.empty())
+    {
+        return false;
+    }
+    return image.datastart < input.image.dataend && input.image.datastart < image.dataend;
+}
+
+bool MyImage::isInPlace(MyImage &input)
+{
+    return image.data == input.image.data && image.step[0] == input.image.step[0] &&
+        image.rows == input.image.rows && image.cols == input.image.cols && image.type() == input.image.type();
+}
+
+bool MyImage::matchInput(MyImage &input)
+{
+    // an output of another size or type starts from a zero frame shaped like the input, its
+    // region of interest would not fit the input anyway; true when that new frame was made
+    if(image.rows != input.image.rows || image.cols != input.image.cols || image.type() != input.image.type())
+    {
+        setImageMatchZero(input);
+        return true;
+    }
+    return false;
+}
+
+void MyImage::separateFrom(MyImage &input)
+{
+    // an exact alias is safe for per pixel transforms, a shifted overlap would read pixels the
+    // same pass already wrote, so only then the source gets its own copy
+    if(sharesPixelsWith(input) && !isInPlace(input))
+    {
+        input.image = input.image.clone();
+    }
+}
+
 // ------ GET IMAGE MATRIX INFO -------------------------------------------------------------------
 uint32_t MyImage::getCols()
 {
@@ -82,15 +545,22 @@ uint8_t MyImage::getIntensity(uint32_t row, uint32_t col)
     return image.at<uchar>(row,col);
 }
 
+uint64_t MyImage::getImageVersion()
+{
+    return imageVersion;
+}
+
 // ------ HISTOGRAM -------------------------------------------------------------------------------
 void MyImage::resetIntensityHistograms()
 {
+    histogramVersion = 0;
     intensityBins.clear();
     intensityDistribution.clear();
     intensityPDF.clear();
     intensityCDF.clear();
     intensityTransform.clear();
     intensityEqualized.clear();
+    intensityCumulative.clear();
 
     intensityBins.fill(0,numberBins);
     intensityDistribution.fill(0,numberBins);
@@ -98,6 +568,7 @@ void MyImage::resetIntensityHistograms()
     intensityCDF.fill(0,numberBins);
     intensityTransform.fill(0,numberBins);
     intensityEqualized.fill(0,numberBins);
+    intensityCumulative.fill(0,numberBins);
 }
 
 void MyImage::setIntensityHistograms()
@@ -106,10 +577,51 @@ void MyImage::setIntensityHistograms()
 
     buildIntensityBins();
     buildIntensityDistribution();
-    buildIntensityPDF();
-    buildIntensityCDF();
-    buildIntensityTransform();
+    buildIntensityCumulative();
+    buildIntensityEqualized();
+    histogramVersion = imageVersion;
+}
+
+void MyImage::setIntensityHistogramsFromSource(MyImage source)
+{
+    // the transform is a pure intensity mapping, so the histogram of the transformed source
+    // follows from routing each source bin through intensityCalculation without a pixel pass
+    QVector<double> distribution(numberBins, 0);
+
+    int i = -1;
+    for(uint16_t bin=0; bin<numberBins; bin++)
+    {
+        i = round(intensityCalculation.at(bin));
+        i = std::max(0, std::min((int)maxBin, i));
+        distribution[i] = distribution.at(i) + source.intensityDistribution.at(bin);
+    }
+
+    setIntensityHistogramsFromDistribution(distribution);
+}
+
+void MyImage::setIntensityHistogramsFromDistribution(QVector<double> distribution)
+{
+    resetIntensityHistograms();
+    intensityDistribution = distribution;
+
+    buildIntensityBins();
+    buildIntensityCumulative();
     buildIntensityEqualized();
+    histogramVersion = imageVersion;
+}
+
+void MyImage::setIntensityHistogramsFromCalculation(MyImage &input)
+{
+    // when input counted the same pixels this image was just written from, the new histogram is
+    // the old one routed through the lookup, otherwise the written pixels are counted again
+    bool sameSelection = region == input.region && regionMask.data == input.regionMask.data;
+
+    if(sameSelection && input.histogramVersion != 0 && input.histogramVersion == input.imageVersion)
+    {
+        setIntensityHistogramsFromSource(input);
+        return;
+    }
+    setIntensityHistograms();
 }
 
 void MyImage::buildIntensityBins()
@@ -122,134 +634,136 @@ void MyImage::buildIntensityBins()
 
 void MyImage::buildIntensityDistribution()
 {
-    int i = -1;
+    cv::Mat target = getRegion();
+    cv::Mat mask = getRegionMask();
+    std::vector<uint64_t> counts(numberBins, 0);
+    const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
 
-    for(uint16_t row=0; row < image.rows; row++) {
-        for (uint16_t col=0; col < image.cols; col++)
+    for(int row=0; row < target.rows; row++)
+    {
+        const uchar *pixel = target.ptr<uchar>(row);
+        const uchar *allowed = mask.empty() ? 0 : mask.ptr<uchar>(row);
+
+        if(!allowed)
+        {
+            kernels.countHistogram(pixel, target.cols, counts.data());
+            continue;
+        }
+
+        for(int col=0; col < target.cols; col++)
         {
-            i = getIntensity(row,col);
-            intensityDistribution.replace(i,intensityDistribution.at(i)+1);
+            if(allowed[col])
+            {
+                counts[pixel[col]]++;
+            }
         }
     }
-}
 
-void MyImage::buildIntensityPDF()
-{
-    double tmp;
     for(uint16_t i=0; i<numberBins; i++)
     {
-        tmp = intensityDistribution.at(i) / getSize();
-        intensityPDF.replace(i,tmp);
+        intensityDistribution.replace(i,counts[i]);
     }
 }
 
-void MyImage::buildIntensityCDF()
+void MyImage::buildIntensityCumulative()
 {
-    double tmp = 0;
+    // one pass over the bins: integer prefix sum, then PDF, CDF and the equalization transform.
+    // the transform is rounded in integer arithmetic, so equalization is exact on every platform
+    const double *distribution = intensityDistribution.constData();
+    quint64 *cumulative = intensityCumulative.data();
+    double *pdf = intensityPDF.data();
+    double *cdf = intensityCDF.data();
+    double *transform = intensityTransform.data();
+
+    quint64 total = 0;
     for(uint16_t i=0; i<numberBins; i++)
     {
-        tmp = tmp + intensityPDF.at(i);
-        intensityCDF.replace(i,tmp);
+        total = total + (quint64)distribution[i];
     }
-}
 
-void MyImage::buildIntensityTransform()
-{
-    double tmp = 0;
+    quint64 sum = 0;
+    quint64 count = 0;
     for(uint16_t i=0; i<numberBins; i++)
     {
-        tmp = intensityCDF.at(i) * maxBin;
-        intensityTransform.replace(i,tmp);
+        count = (quint64)distribution[i];
+        sum = sum + count;
+        cumulative[i] = sum;
+
+        if(total > 0)
+        {
+            pdf[i] = (double)count / total;
+            cdf[i] = (double)sum / total;
+            transform[i] = (sum * maxBin + total / 2) / total;
+        }
     }
 }
 
 void MyImage::buildIntensityEqualized()
 {
+    // every pixel of a bin lands in the same equalized bin, so route whole bins
     int i = -1;
-    for(uint16_t row=0; row < image.rows; row++) {
-        for (uint16_t col=0; col < image.cols; col++)
-        {
-            i = intensityTransform.at(getIntensity(row,col));
-            intensityEqualized.replace(i,intensityEqualized.at(i)+1);
-        }
+    for(uint16_t bin=0; bin<numberBins; bin++)
+    {
+        i = intensityTransform.at(bin);
+        intensityEqualized.replace(i,intensityEqualized.at(i)+intensityDistribution.at(bin));
     }
 }
 
-// -----  IMAGE PROCESSING FUNCTIONS --------------------------------------------------------------
-void MyImage::buildIntensityCalculation(MyImage input, uint8_t toolSwitch, double value)
+// ----- STATISTICS -------------------------------------------------------------------------------
+MyStatistics MyImage::getStatistics()
 {
-    intensityCalculation.clear();
-    intensityCalculation.fill(0,numberBins);
-
-    intensityMin = maxBin;
-    intensityMax = 0;
+    // an 8 bit image usually has a current histogram already, 16 bit counts are kept until the
+    // pixels or the region change, so repeated calls never read a pixel again
+    if(image.depth() == CV_8U)
+    {
+        if(histogramVersion != imageVersion)
+        {
+            setIntensityHistograms();
+        }
+        return MyStatistics(intensityDistribution);
+    }
 
-    double tmp = 0;
+    if(image.depth() != CV_16U)
+    {
+        return MyStatistics();
+    }
 
-    for (int i=0; i<numberBins; i++)
-    {
-        switch (toolSwitch){
-        case 1:
-            tmp = i;
-            break;
-        case 2:
-            tmp = maxBin - i;
-            break;
-        case 3:
-            tmp = i << (unsigned int)(value);
-            break;
-        case 4:
-            tmp = i >> (unsigned int)(value);
-            break;
-        case 5:
-            tmp = i * value;
-            break;
-        case 6:
-            tmp = i / value;
-            break;
-        case 7:
-            tmp = exp(1.0*i/255.0);
-            break;
-        case 8:
-            tmp = log(1.0+i);
-            break;
-        case 9:
-            tmp = pow(i,value);
-            break;
-        case 10:
-            tmp = log(i+1)/log(value+1);
-            break;
-        case 11:
-            tmp = input.intensityTransform.at(i);
-            break;
-        default:
-            tmp = i;
-            break;
-        }
+    if(wideDistributionVersion != imageVersion)
+    {
+        cv::Mat target = getRegion();
+        cv::Mat mask = getRegionMask();
+        wideDistribution.fill(0, 65536);
 
-        if (tmp>intensityMax)
+        for(int row=0; row < target.rows; row++)
         {
-            intensityMax = tmp;
-        }
+            const uint16_t *pixel = target.ptr<uint16_t>(row);
+            const uchar *allowed = mask.empty() ? 0 : mask.ptr<uchar>(row);
 
-        if (tmp<intensityMin)
-        {
-            intensityMin = tmp;
+            for(int col=0; col < target.cols; col++)
+            {
+                if(!allowed || allowed[col])
+                {
+                    wideDistribution[pixel[col]]++;
+                }
+            }
         }
-
-        intensityCalculation.replace(i,tmp);
+        wideDistributionVersion = imageVersion;
     }
-
-    rebinIntensityCalculation(0,maxBin);
-    setIntensityCalculation(input);
-    setIntensityHistograms();
+    return MyStatistics(wideDistribution);
 }
 
+// -----  IMAGE PROCESSING FUNCTIONS --------------------------------------------------------------
 void MyImage::rebinIntensityCalculation(int tmpMIN, int tmpMAX)
 {
     int tmpRange = abs(tmpMAX - tmpMIN);
     double tmp = 0;
 
+    if(intensityMax <= 0)
+    {
+        // an all zero table, a right shift past the pixel width, has nothing to stretch
+        return;
+    }
+
     for(int i=0; i<=tmpRange; i++)
     {
         tmp = (tmpMAX / intensityMax) * (intensityCalculation.at(i) - intensityMin + tmpMIN);
@@ -259,67 +773,306 @@ void MyImage::rebinIntensityCalculation(int tmpMIN, int tmpMAX)
 
 void MyImage::setIntensityCalculation(MyImage input)
 {
-    for (uint16_t row=0; row < image.rows; row++) {
-        for (uint16_t col=0; col < image.cols; col++)
+    // only the region of interest is written, pixels outside of it are left untouched
+    cv::Mat target = getRegion();
+    cv::Mat source = region.empty() ? input.image : input.image(region);
+    cv::Mat mask = getRegionMask();
+
+    uchar lookup[numberBins];
+    for(uint16_t i=0; i<numberBins; i++)
+    {
+        lookup[i] = round(intensityCalculation.at(i));
+    }
+
+    const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
+
+    for(int row=0; row < target.rows; row++)
+    {
+        const uchar *pixel = source.ptr<uchar>(row);
+        const uchar *allowed = mask.empty() ? 0 : mask.ptr<uchar>(row);
+        uchar *result = target.ptr<uchar>(row);
+
+        if(!allowed)
         {
-            image.at<uchar>(row,col) = round(intensityCalculation.at(input.getIntensity(row,col)));
+            kernels.applyLookup(pixel, result, target.cols, lookup);
+            continue;
+        }
+
+        for(int col=0; col < target.cols; col++)
+        {
+            if(allowed[col])
+            {
+                result[col] = lookup[pixel[col]];
+            }
         }
     }
+    resetPyramid();
 }
 
 void MyImage::processPositive(MyImage input)
 {
-    buildIntensityCalculation(input,1,0);
+    buildIntensityCalculation(input, MyTransform::Positive());
 }
 
 void MyImage::processNegative(MyImage input)
 {
-    buildIntensityCalculation(input,2,0);
+    buildIntensityCalculation(input, MyTransform::Negative());
 }
 
 void MyImage::processBitShiftLeft(MyImage input, int numberBits)
 {
-    buildIntensityCalculation(input,3,numberBits);
+    buildIntensityCalculation(input, MyTransform::Shift<MyTransform::Up>(numberBits));
 }
 
 void MyImage::processBitShiftRight(MyImage input, int numberBits)
 {
-    buildIntensityCalculation(input,4,numberBits);
+    buildIntensityCalculation(input, MyTransform::Shift<MyTransform::Down>(numberBits));
 }
 
 void MyImage::processScaleUp(MyImage input, double scalingFactor)
 {
-    buildIntensityCalculation(input,5,scalingFactor);
+    buildIntensityCalculation(input, MyTransform::Scale<MyTransform::Up>(scalingFactor));
 }
 
 void MyImage::processScaleDown(MyImage input, double scalingFactor)
 {
-    buildIntensityCalculation(input,6,scalingFactor);
+    buildIntensityCalculation(input, MyTransform::Scale<MyTransform::Down>(scalingFactor));
 }
 
 void MyImage::processExponential(MyImage input)
 {
-    buildIntensityCalculation(input,7,0);
+    buildIntensityCalculation(input, MyTransform::Exponential());
 }
 
 void MyImage::processNaturalLog(MyImage input)
 {
-    buildIntensityCalculation(input,8,0);
+    buildIntensityCalculation(input, MyTransform::NaturalLog());
 }
 
 void MyImage::processPowerLaw(MyImage input, double gamma)
 {
-    buildIntensityCalculation(input,9,gamma);
+    buildIntensityCalculation(input, MyTransform::Power(gamma));
 }
 
 void MyImage::processBaseLog(MyImage input, double base)
 {
-    buildIntensityCalculation(input,10,base);
+    buildIntensityCalculation(input, MyTransform::BaseLog(base));
 }
 
 void MyImage::processEqualize(MyImage input)
 {
-    buildIntensityCalculation(input,11,0);
+    // intensityTransform is only counted for 8 bit images, wide pixel types are stretched from
+    // their minimum to their maximum like processAutoContrast does instead of reading zeros
+    if(input.image.depth() != CV_8U)
+    {
+        processPositive(input);
+        return;
+    }
+    buildIntensityCalculation(input, MyTransform::Equalize(input.intensityTransform.constData()));
+}
+
+bool MyImage::processAutoContrast(MyImage input, double lowPercent, double highPercent)
+{
+    // from 50 % on the cutoffs would meet or cross and the stretch would silently do nothing
+    if(!(lowPercent >= 0 && lowPercent < 50 && highPercent >= 0 && highPercent < 50))
+    {
+        return false;
+    }
+
+    // the cutoffs come from the histogram of input, so only the lookup pass reads pixels; wide
+    // pixel types have no histogram and are stretched from their minimum to their maximum
+    if(input.image.depth() != CV_8U)
+    {
+        processPositive(input);
+        return true;
+    }
+
+    MyStatistics statistics = input.getStatistics();
+    double low = statistics.getPercentile(lowPercent);
+    double high = statistics.getPercentile(100 - highPercent);
+    buildIntensityCalculation(input, MyTransform::Stretch(low, high));
+    return true;
+}
+
+bool MyImage::processHistogramMatch(MyImage input, MyImage reference)
+{
+    if(reference.image.depth() != CV_8U)
+    {
+        return false;
+    }
+    return processHistogramMatch(input, reference.intensityCDF);
+}
+
+bool MyImage::processHistogramMatch(MyImage input, QVector<double> referenceCDF)
+{
+    // the match is a 256 entry lookup, wide pixel types have no CDF to match and are refused
+    // before anything is written
+    if(input.image.depth() != CV_8U || referenceCDF.size() != numberBins)
+    {
+        return false;
+    }
+
+    // batch callers keep referenceCDF and skip rebuilding the reference histograms per image
+    buildMatchLookup(input.intensityCDF, referenceCDF);
+    matchInput(input);
+    separateFrom(input);
+    setIntensityCalculation(input);
+    setIntensityHistogramsFromCalculation(input);
+    return true;
+}
+
+void MyImage::buildMatchLookup(QVector<double> sourceCDF, QVector<double> referenceCDF)
+{
+    // map each level to the first reference level whose CDF reaches the source CDF, both CDFs
+    // are monotonic so the reference index only ever moves forward
+    const double tolerance = 1e-12;
+
+    intensityCalculation.clear();
+    intensityCalculation.fill(0,numberBins);
+
+    int z = 0;
+    for(int i=0; i<numberBins; i++)
+    {
+        while(z < maxBin && referenceCDF.at(z) + tolerance < sourceCDF.at(i))
+        {
+            z++;
+        }
+        intensityCalculation.replace(i,z);
+    }
+}
+
+void MyImage::processAdaptiveEqualize(MyImage input, uint16_t gridRows, uint16_t gridCols, double clipLimit)
+{
+    // contrast limited adaptive histogram equalization: every tile gets its own clipped
+    // equalization lookup, each pixel blends the lookups of the four nearest tile centers
+    if(input.image.depth() != CV_8U)
+    {
+        processPositive(input);
+        return;
+    }
+
+    matchInput(input);
+    separateFrom(input);
+    cv::Mat target = getRegion();
+    cv::Mat source = region.empty() ? input.image : input.image(region);
+    cv::Mat mask = getRegionMask();
+
+    if(source.empty())
+    {
+        return;
+    }
+
+    int rows = std::max(1, std::min((int)gridRows, source.rows));
+    int cols = std::max(1, std::min((int)gridCols, source.cols));
+
+    std::vector<uchar> lookups(rows * cols * numberBins);
+    cv::parallel_for_(cv::Range(0, rows * cols), MyTileLookupBody(source, rows, cols, clipLimit, lookups));
+
+    std::vector<int> rowTile, rowWeight, colTile, colWeight;
+    buildTileWeights(source.rows, rows, rowTile, rowWeight);
+    buildTileWeights(source.cols, cols, colTile, colWeight);
+
+    // every lookup is complete before the first pixel is written, so input may be this image
+    cv::parallel_for_(cv::Range(0, source.rows), MyTileInterpolationBody(source, target, mask, lookups, cols,
+        rowTile, rowWeight, colTile, colWeight));
+
+    resetPyramid();
+    setIntensityHistograms();
+}
+
+void MyImage::processLocalEqualize(MyImage input, uint16_t radius)
+{
+    // every pixel is equalized against the histogram of the (2 radius + 1)^2 window around it
+    if(input.image.depth() != CV_8U)
+    {
+        processPositive(input);
+        return;
+    }
+
+    matchInput(input);
+    cv::Mat target = getRegion();
+    cv::Mat source = region.empty() ? input.image : input.image(region);
+    cv::Mat mask = getRegionMask();
+
+    if(source.empty())
+    {
+        return;
+    }
+
+    if(sharesPixelsWith(input))
+    {
+        // the window reads rows that are already written, keep the original neighbourhood
+        source = source.clone();
+    }
+
+    int bands = std::max(1, std::min(cv::getNumThreads(), source.rows));
+    cv::parallel_for_(cv::Range(0, bands), MyLocalEqualizeBody(source, target, mask, radius, bands));
+
+    resetPyramid();
+    setIntensityHistograms();
+}
+
+// ----- IMAGE PYRAMID ----------------------------------------------------------------------------
+uint8_t MyImage::getPyramidLevelForScale(double scale)
+{
+    // pick the coarsest level that still has at least one source pixel per screen pixel
+    uint8_t level = 0;
+    uint32_t rows = getRows();
+    uint32_t cols = getCols();
+
+    while(scale > 0 && scale <= 0.5 && rows > 1 && cols > 1)
+    {
+        scale = scale * 2;
+        rows = (rows + 1) / 2;
+        cols = (cols + 1) / 2;
+        level++;
+    }
+    return level;
+}
+
+cv::Mat MyImage::getPyramidLevel(uint8_t level)
+{
+    if(pyramid.empty())
+    {
+        pyramid.push_back(image);
+    }
+
+    while(pyramid.size() <= level)
+    {
+        cv::Mat &previous = pyramid.back();
+        cv::Mat next;
+
+        if(previous.rows <= 1 || previous.cols <= 1)
+        {
+            return previous;
+        }
+
+        cv::resize(previous, next, cv::Size((previous.cols + 1) / 2, (previous.rows + 1) / 2), 0, 0, cv::INTER_AREA);
+        pyramid.push_back(next);
+    }
+    return pyramid.at(level);
+}
+
+uint8_t MyImage::getBuiltPyramidLevel(uint8_t level)
+{
+    // the finest level already built that is not finer than asked for, never builds a new one
+    if(pyramid.empty())
+    {
+        pyramid.push_back(image);
+    }
+    return std::min<size_t>(level, pyramid.size() - 1);
+}
+
+void MyImage::buildPyramid()
+{
+    // every level down to a single row or column, about a third of the image on top
+    getPyramidLevel(getPyramidLevelForScale(0.5 / std::max(getRows(), getCols())));
+}
+
+void MyImage::resetPyramid()
+{
+    pyramid.clear();
+    imageVersion = nextImageVersion++;
 }
 
 // ----- IMAGE OUTPUT -----------------------------------------------------------------------------
@@ -341,3 +1094,9 @@ void MyImage::saveImageToPNG(QString outputPath)
 
     cv::imwrite(filePath.toStdString(), image, compression_parameters);
 }
+
+bool MyImage::saveImageToPath(QString filePath)
+{
+    // the file type follows from the extension of filePath
+    return cv::imwrite(filePath.toStdString(), image);
+}
@@ -1,11 +1,20 @@
 #ifndef MYIMAGE_H
 #define MYIMAGE_H
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <math.h>
-#include <QFileDialog>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <QVector>
 #include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "mystatistics.h"
+#include "mytransform.h"
 
 class MyImage
 {
@@ -22,17 +31,32 @@ public:
 
     // --- INITIALIZATION ---
     void setImageFromPath(std::string image_path);
+    void setImageFromMatrix(cv::Mat input, bool countHistograms = true); // no pixels are copied
     void setImageMatchZero(MyImage input);
     void setImageToZero(uint32_t rows, uint32_t cols, int type);
     void setImageToDefault(QString filePath);
+    void setImageToProxy(MyImage &input, uint32_t maxRows, uint32_t maxCols);
     void setTitle(QString input);
 
+    // --- REGION OF INTEREST ---
+    void setRegionOfInterest(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    void setRegionMask(cv::Mat mask);
+    void clearRegionOfInterest();
+    bool hasRegionOfInterest();
+    cv::Mat getRegion();
+    cv::Mat getRegionMask();
+
+    // --- ALIASING ---
+    bool sharesPixelsWith(MyImage &input);
+    bool isInPlace(MyImage &input); // same pixels, same layout, every pixel only reads itself
+
     // --- GET IMAGE MATRIX INFO ---
     uint32_t getCols();
     uint32_t getRows();
     uint64_t getSize();
     int getType();
     uint8_t getIntensity(uint32_t row, uint32_t col);
+    uint64_t getImageVersion();
 
     // --- HISTOGRAM ---
     QVector<double> intensityBins;
@@ -41,26 +65,37 @@ public:
     QVector<double> intensityCDF;
     QVector<double> intensityTransform;
     QVector<double> intensityEqualized;
+    QVector<quint64> intensityCumulative; // exact pixel count at or below each bin
 
     void resetIntensityHistograms();
     void setIntensityHistograms();
+    void setIntensityHistogramsFromSource(MyImage source);
+    void setIntensityHistogramsFromDistribution(QVector<double> distribution);
     void buildIntensityBins();
     void buildIntensityDistribution();
-    void buildIntensityPDF();
-    void buildIntensityCDF();
-    void buildIntensityTransform();
+    void buildIntensityCumulative();
     void buildIntensityEqualized();
 
+    // --- STATISTICS ---
+    MyStatistics getStatistics(); // from the histogram, 8 and 16 bit images, empty for float
+
     // --- IMAGE PROCESSING FUNCTIONS ---
     QVector<double> intensityCalculation;
 
-    void buildIntensityCalculation(MyImage input, uint8_t toolSwitch, double value);
+    template<class Op> void buildIntensityCalculation(MyImage input, Op op);
+    template<class Op> void buildIntensityLookup(Op op);
     void setIntensityCalculation(MyImage input);
     void rebinIntensityCalculation(int minBin, int maxBin);
     void processBaseLog(MyImage input, double base);
     void processBitShiftLeft(MyImage input, int numberBits);
     void processBitShiftRight(MyImage input, int numberBits);
     void processEqualize(MyImage input);
+    bool processHistogramMatch(MyImage input, MyImage reference); // false unless both are 8 bit
+    bool processHistogramMatch(MyImage input, QVector<double> referenceCDF);
+    void buildMatchLookup(QVector<double> sourceCDF, QVector<double> referenceCDF);
+    void processAdaptiveEqualize(MyImage input, uint16_t gridRows, uint16_t gridCols, double clipLimit);
+    bool processAutoContrast(MyImage input, double lowPercent, double highPercent); // false unless both in [0, 50)
+    void processLocalEqualize(MyImage input, uint16_t radius);
     void processExponential(MyImage input);
     void processNaturalLog(MyImage input);
     void processNegative(MyImage input);
@@ -69,9 +104,17 @@ public:
     void processScaleDown(MyImage input, double scalingFactor);
     void processScaleUp(MyImage input, double scalingFactor);
 
+    // --- IMAGE PYRAMID ---
+    uint8_t getPyramidLevelForScale(double scale);
+    cv::Mat getPyramidLevel(uint8_t level);
+    uint8_t getBuiltPyramidLevel(uint8_t level);
+    void buildPyramid();
+    void resetPyramid();
+
     // --- IMAGE OUTPUT ---
     QImage getQImage();
     void saveImageToPNG(QString outputPath);
+    bool saveImageToPath(QString filePath);
 
 private:
     // --- OBJECT TITLE ---
@@ -79,11 +122,99 @@ private:
 
     // --- IMAGE DIMENSIONS ---
     cv::Mat image; // openCV matrix file containing image data
+    std::vector<cv::Mat> pyramid; // lazily built half resolution levels, pyramid[0] is image
+    uint64_t imageVersion; // unique across all images, changes whenever the pixels change
+
+    // --- REGION OF INTEREST ---
+    cv::Rect region; // empty rectangle selects the whole image
+    cv::Mat regionMask; // optional, full image size, non-zero pixels take part
 
     // --- IMAGE STATISTICS ---
     double intensityMin; // minimum intensity value in image matrix
     double intensityMax; // maximum intensity value in image matrix
+    uint64_t histogramVersion; // imageVersion the histograms were counted for, 0 when stale
+    QVector<double> wideDistribution; // 65536 bins of a 16 bit image, counted on demand
+    uint64_t wideDistributionVersion; // imageVersion of wideDistribution, 0 when stale
+
+    // --- IN PLACE SUPPORT ---
+    bool matchInput(MyImage &input);
+    void separateFrom(MyImage &input);
+    void setIntensityHistogramsFromCalculation(MyImage &input);
 
 };
 
+// --- TYPED TRANSFORMS ---
+template<class Op>
+void MyImage::buildIntensityCalculation(MyImage input, Op op)
+{
+    // input may be this image, the transform is then applied in place without a second frame
+    bool created = matchInput(input);
+    separateFrom(input);
+
+    if(input.image.depth() != CV_8U)
+    {
+        // no lookup table for wide pixel types, the transform is evaluated per pixel and then
+        // stretched over the range of the type the same way rebinIntensityCalculation does; like
+        // the 8 bit path only the selection is written, a new frame starts as a copy of the input
+        if(created)
+        {
+            input.image.copyTo(image);
+        }
+        cv::Mat target = getRegion();
+        cv::Mat source = region.empty() ? input.image : input.image(region);
+        cv::Mat mask = getRegionMask();
+        double top = image.depth() == CV_16U ? 65535 : 1;
+
+        if(mask.empty())
+        {
+            MyTransform::applyNormalized(source, target, op, top);
+        }
+        else
+        {
+            cv::Mat result(target.size(), target.type());
+            MyTransform::applyNormalized(source, result, op, top);
+            result.copyTo(target, mask);
+        }
+        resetPyramid();
+        resetIntensityHistograms();
+        return;
+    }
+
+    buildIntensityLookup(op);
+    setIntensityCalculation(input);
+    setIntensityHistogramsFromCalculation(input);
+}
+
+template<class Op>
+void MyImage::buildIntensityLookup(Op op)
+{
+    // fills intensityCalculation without touching any pixels
+    intensityCalculation.clear();
+    intensityCalculation.fill(0,numberBins);
+
+    intensityMin = maxBin;
+    intensityMax = 0;
+
+    double tmp = 0;
+
+    for (int i=0; i<numberBins; i++)
+    {
+        tmp = op(double(i));
+
+        if (tmp>intensityMax)
+        {
+            intensityMax = tmp;
+        }
+
+        if (tmp<intensityMin)
+        {
+            intensityMin = tmp;
+        }
+
+        intensityCalculation.replace(i,tmp);
+    }
+
+    rebinIntensityCalculation(0,maxBin);
+}
+
 #endif // MYIMAGE_H
@@ -2,7 +2,26 @@ INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
 SOURCES += \
-    $$PWD/myimage.cpp
+    $$PWD/mybufferpool.cpp \
+    $$PWD/mycapi.cpp \
+    $$PWD/mydispatch.cpp \
+    $$PWD/myimage.cpp \
+    $$PWD/mymath.cpp \
+    $$PWD/myoperation.cpp \
+    $$PWD/myresultcache.cpp \
+    $$PWD/mystatistics.cpp \
+    $$PWD/mystream.cpp
 
 HEADERS += \
-    $$PWD/myimage.h
+    $$PWD/mybufferpool.h \
+    $$PWD/mycapi.h \
+    $$PWD/mydispatch.h \
+    $$PWD/myimage.h \
+    $$PWD/mymath.h \
+    $$PWD/myoperation.h \
+    $$PWD/myresultcache.h \
+    $$PWD/mystatistics.h \
+    $$PWD/mystream.h \
+    $$PWD/mytransform.h
+
+LIBS += -ltiff
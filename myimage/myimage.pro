@@ -0,0 +1,17 @@
+# libmyimage, static by default, CONFIG+=myimage_shared builds a shared library; mycapi.h is its
+# plain C interface for callers outside of Qt and C++
+
+TEMPLATE = lib
+TARGET = myimage
+
+QT = core gui
+
+myimage_shared {
+    CONFIG += shared
+    DEFINES += MYIMAGE_BUILD_SHARED
+}
+else: CONFIG += staticlib
+
+include(../build.pri)
+include(../opencv.pri)
+include(myimage.pri)
@@ -0,0 +1,504 @@
+#include "mymath.h"
+#include "mydispatch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MYMATH_X86
+#define MYMATH_SSE2 __attribute__((target("sse2")))
+#define MYMATH_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+// ----- CONSTANTS --------------------------------------------------------------------------------
+// exp and log follow the Cephes single precision reductions and polynomials, pow is evaluated in
+// double so the error of log(x) is not multiplied by the exponent before it reaches exp
+static const float expLow = -104.0f; // below this the result underflows to zero
+static const float expHigh = 89.0f; // above this the result overflows to infinity
+static const float log2e = 1.44269504088896341f;
+static const float ln2Hi = 0.693359375f;
+static const float ln2Lo = -2.12194440e-4f;
+static const float sqrtHalf = 0.707106781186547524f;
+static const float expPoly[] = { 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f };
+static const float logPoly[] = { 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+                                 -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+                                 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f };
+static const double powLn2 = 0.69314718055994530942;
+static const double powLn2Hi = 6.93147180369123816490e-01;
+static const double powLn2Lo = 1.90821492927058770002e-10;
+static const double powLog2e = 1.44269504088896340736;
+
+// ----- SCALAR -----------------------------------------------------------------------------------
+static void scalarExp(const float *input, float *output, int count)
+{
+    for(int i=0; i<count; i++)
+    {
+        output[i] = std::exp(input[i]);
+    }
+}
+
+static void scalarLog(const float *input, float *output, int count)
+{
+    for(int i=0; i<count; i++)
+    {
+        output[i] = std::log(input[i]);
+    }
+}
+
+static void scalarPow(const float *input, float *output, int count, float exponent)
+{
+    for(int i=0; i<count; i++)
+    {
+        output[i] = std::pow(input[i], exponent);
+    }
+}
+
+#ifdef MYMATH_X86
+// ----- SSE2 -------------------------------------------------------------------------------------
+static inline MYMATH_SSE2 __m128 sse2Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline MYMATH_SSE2 __m128 sse2Scale(__m128 y, __m128i n)
+{
+    // y * 2^n, split in two factors so both ends of the range stay representable
+    __m128i half = _mm_srai_epi32(n, 1);
+    __m128i bias = _mm_set1_epi32(127);
+    __m128 first = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(half, bias), 23));
+    __m128 second = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(n, half), bias), 23));
+    return _mm_mul_ps(_mm_mul_ps(y, first), second);
+}
+
+static inline MYMATH_SSE2 __m128 sse2Exp(__m128 x)
+{
+    __m128 invalid = _mm_cmpunord_ps(x, x);
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(expLow)), _mm_set1_ps(expHigh));
+
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(log2e)));
+    __m128 fn = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(ln2Hi))), _mm_mul_ps(fn, _mm_set1_ps(ln2Lo)));
+
+    __m128 p = _mm_set1_ps(expPoly[0]);
+    for(int k=1; k<6; k++)
+    {
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(expPoly[k]));
+    }
+    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+
+    return _mm_or_ps(sse2Scale(y, n), invalid);
+}
+
+static inline MYMATH_SSE2 void sse2Reduce(__m128 x, __m128 &mantissa, __m128 &exponent)
+{
+    // x = mantissa * 2^exponent with mantissa in [sqrt(1/2), sqrt(2)), subnormals included
+    __m128 subnormal = _mm_cmplt_ps(x, _mm_set1_ps(std::numeric_limits<float>::min()));
+    x = sse2Select(subnormal, _mm_mul_ps(x, _mm_set1_ps(8388608.0f)), x);
+
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126));
+    e = _mm_sub_epi32(e, _mm_and_si128(_mm_castps_si128(subnormal), _mm_set1_epi32(23)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+
+    __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(sqrtHalf));
+    mantissa = _mm_add_ps(m, _mm_and_ps(small, m));
+    exponent = _mm_sub_ps(_mm_cvtepi32_ps(e), _mm_and_ps(small, _mm_set1_ps(1.0f)));
+}
+
+static inline MYMATH_SSE2 __m128 sse2Log(__m128 x)
+{
+    __m128 mantissa, exponent;
+    sse2Reduce(x, mantissa, exponent);
+
+    __m128 m = _mm_sub_ps(mantissa, _mm_set1_ps(1.0f));
+    __m128 z = _mm_mul_ps(m, m);
+    __m128 p = _mm_set1_ps(logPoly[0]);
+    for(int k=1; k<9; k++)
+    {
+        p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(logPoly[k]));
+    }
+    __m128 y = _mm_mul_ps(_mm_mul_ps(p, m), z);
+    y = _mm_add_ps(y, _mm_mul_ps(exponent, _mm_set1_ps(ln2Lo)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    __m128 result = _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(exponent, _mm_set1_ps(ln2Hi)));
+
+    // infinity and NaN pass through, zero gives -infinity, negative gives NaN
+    __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    result = sse2Select(_mm_cmpnlt_ps(x, infinity), x, result);
+    result = sse2Select(_mm_cmpeq_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_setzero_ps(), infinity), result);
+    return _mm_or_ps(result, _mm_cmplt_ps(x, _mm_setzero_ps()));
+}
+
+static MYMATH_SSE2 void sse2Exp(const float *input, float *output, int count)
+{
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(output + i, sse2Exp(_mm_loadu_ps(input + i)));
+    }
+    if(i < count)
+    {
+        float tail[4] = {0, 0, 0, 0};
+        memcpy(tail, input + i, (count - i) * sizeof(float));
+        _mm_storeu_ps(tail, sse2Exp(_mm_loadu_ps(tail)));
+        memcpy(output + i, tail, (count - i) * sizeof(float));
+    }
+}
+
+static MYMATH_SSE2 void sse2Log(const float *input, float *output, int count)
+{
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(output + i, sse2Log(_mm_loadu_ps(input + i)));
+    }
+    if(i < count)
+    {
+        float tail[4] = {1, 1, 1, 1};
+        memcpy(tail, input + i, (count - i) * sizeof(float));
+        _mm_storeu_ps(tail, sse2Log(_mm_loadu_ps(tail)));
+        memcpy(output + i, tail, (count - i) * sizeof(float));
+    }
+}
+
+// ----- AVX2 -------------------------------------------------------------------------------------
+static inline MYMATH_AVX2 __m256 avx2Scale(__m256 y, __m256i n)
+{
+    __m256i half = _mm256_srai_epi32(n, 1);
+    __m256i bias = _mm256_set1_epi32(127);
+    __m256 first = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(half, bias), 23));
+    __m256 second = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_sub_epi32(n, half), bias), 23));
+    return _mm256_mul_ps(_mm256_mul_ps(y, first), second);
+}
+
+static inline MYMATH_AVX2 __m256 avx2Exp(__m256 x)
+{
+    __m256 invalid = _mm256_cmp_ps(x, x, _CMP_UNORD_Q);
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(expLow)), _mm256_set1_ps(expHigh));
+
+    __m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(log2e)));
+    __m256 fn = _mm256_cvtepi32_ps(n);
+    __m256 r = _mm256_fnmadd_ps(fn, _mm256_set1_ps(ln2Lo), _mm256_fnmadd_ps(fn, _mm256_set1_ps(ln2Hi), x));
+
+    __m256 p = _mm256_set1_ps(expPoly[0]);
+    for(int k=1; k<6; k++)
+    {
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expPoly[k]));
+    }
+    __m256 y = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r), _mm256_set1_ps(1.0f));
+
+    return _mm256_or_ps(avx2Scale(y, n), invalid);
+}
+
+static inline MYMATH_AVX2 void avx2Reduce(__m256 x, __m256 &mantissa, __m256 &exponent)
+{
+    __m256 subnormal = _mm256_cmp_ps(x, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+    x = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), subnormal);
+
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126));
+    e = _mm256_sub_epi32(e, _mm256_and_si256(_mm256_castps_si256(subnormal), _mm256_set1_epi32(23)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                   _mm256_set1_epi32(0x3f000000)));
+
+    __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(sqrtHalf), _CMP_LT_OQ);
+    mantissa = _mm256_add_ps(m, _mm256_and_ps(small, m));
+    exponent = _mm256_sub_ps(_mm256_cvtepi32_ps(e), _mm256_and_ps(small, _mm256_set1_ps(1.0f)));
+}
+
+static inline MYMATH_AVX2 __m256 avx2Log(__m256 x)
+{
+    __m256 mantissa, exponent;
+    avx2Reduce(x, mantissa, exponent);
+
+    __m256 m = _mm256_sub_ps(mantissa, _mm256_set1_ps(1.0f));
+    __m256 z = _mm256_mul_ps(m, m);
+    __m256 p = _mm256_set1_ps(logPoly[0]);
+    for(int k=1; k<9; k++)
+    {
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(logPoly[k]));
+    }
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+    y = _mm256_fmadd_ps(exponent, _mm256_set1_ps(ln2Lo), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    __m256 result = _mm256_fmadd_ps(exponent, _mm256_set1_ps(ln2Hi), _mm256_add_ps(m, y));
+
+    __m256 infinity = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    result = _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, infinity, _CMP_NLT_UQ));
+    result = _mm256_blendv_ps(result, _mm256_sub_ps(_mm256_setzero_ps(), infinity),
+                              _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+    return _mm256_or_ps(result, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+}
+
+static inline MYMATH_AVX2 __m256d avx2PowHalf(__m256d mantissa, __m256d exponent, __m256d power, __m128i &n)
+{
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d s = _mm256_div_pd(_mm256_sub_pd(mantissa, one), _mm256_add_pd(mantissa, one));
+    __m256d s2 = _mm256_mul_pd(s, s);
+    __m256d p = _mm256_set1_pd(1.0 / 13.0);
+    for(int k=11; k>=1; k-=2)
+    {
+        p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / k));
+    }
+    __m256d logX = _mm256_fmadd_pd(exponent, _mm256_set1_pd(powLn2), _mm256_mul_pd(_mm256_add_pd(s, s), p));
+
+    __m256d t = _mm256_mul_pd(power, logX);
+    t = _mm256_min_pd(_mm256_max_pd(t, _mm256_set1_pd(expLow)), _mm256_set1_pd(expHigh));
+    n = _mm256_cvtpd_epi32(_mm256_mul_pd(t, _mm256_set1_pd(powLog2e)));
+    __m256d fn = _mm256_cvtepi32_pd(n);
+    __m256d r = _mm256_fnmadd_pd(fn, _mm256_set1_pd(powLn2Lo), _mm256_fnmadd_pd(fn, _mm256_set1_pd(powLn2Hi), t));
+
+    __m256d e = _mm256_set1_pd(1.0 / 40320.0);
+    static const double taylor[] = { 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0 };
+    for(int k=0; k<8; k++)
+    {
+        e = _mm256_fmadd_pd(e, r, _mm256_set1_pd(taylor[k]));
+    }
+    return e;
+}
+
+static inline MYMATH_AVX2 __m256 avx2Pow(__m256 x, float exponent)
+{
+    // pow(x, 0) is 1 for every x, zero, infinity and NaN included
+    if(exponent == 0)
+    {
+        return _mm256_set1_ps(1.0f);
+    }
+
+    __m256 mantissa, power2;
+    avx2Reduce(x, mantissa, power2);
+
+    __m256d power = _mm256_set1_pd(exponent);
+    __m128i nLow, nHigh;
+    __m256d low = avx2PowHalf(_mm256_cvtps_pd(_mm256_castps256_ps128(mantissa)),
+                              _mm256_cvtps_pd(_mm256_castps256_ps128(power2)), power, nLow);
+    __m256d high = avx2PowHalf(_mm256_cvtps_pd(_mm256_extractf128_ps(mantissa, 1)),
+                               _mm256_cvtps_pd(_mm256_extractf128_ps(power2, 1)), power, nHigh);
+
+    __m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+    __m256 result = avx2Scale(y, _mm256_inserti128_si256(_mm256_castsi128_si256(nLow), nHigh, 1));
+
+    float atZero = exponent > 0 ? 0.0f : std::numeric_limits<float>::infinity();
+    float atInfinity = exponent > 0 ? std::numeric_limits<float>::infinity() : 0.0f;
+    result = _mm256_blendv_ps(result, _mm256_set1_ps(atZero), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+    result = _mm256_blendv_ps(result, _mm256_set1_ps(atInfinity),
+                              _mm256_cmp_ps(x, _mm256_set1_ps(std::numeric_limits<float>::infinity()), _CMP_EQ_OQ));
+    return _mm256_or_ps(result, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NGE_UQ));
+}
+
+static MYMATH_AVX2 void avx2Exp(const float *input, float *output, int count)
+{
+    int i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(output + i, avx2Exp(_mm256_loadu_ps(input + i)));
+    }
+    if(i < count)
+    {
+        float tail[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        memcpy(tail, input + i, (count - i) * sizeof(float));
+        _mm256_storeu_ps(tail, avx2Exp(_mm256_loadu_ps(tail)));
+        memcpy(output + i, tail, (count - i) * sizeof(float));
+    }
+}
+
+static MYMATH_AVX2 void avx2Log(const float *input, float *output, int count)
+{
+    int i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(output + i, avx2Log(_mm256_loadu_ps(input + i)));
+    }
+    if(i < count)
+    {
+        float tail[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+        memcpy(tail, input + i, (count - i) * sizeof(float));
+        _mm256_storeu_ps(tail, avx2Log(_mm256_loadu_ps(tail)));
+        memcpy(output + i, tail, (count - i) * sizeof(float));
+    }
+}
+
+static MYMATH_AVX2 void avx2Pow(const float *input, float *output, int count, float exponent)
+{
+    int i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(output + i, avx2Pow(_mm256_loadu_ps(input + i), exponent));
+    }
+    if(i < count)
+    {
+        float tail[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+        memcpy(tail, input + i, (count - i) * sizeof(float));
+        _mm256_storeu_ps(tail, avx2Pow(_mm256_loadu_ps(tail), exponent));
+        memcpy(output + i, tail, (count - i) * sizeof(float));
+    }
+}
+#endif
+
+// ----- DISPATCH ---------------------------------------------------------------------------------
+struct MyMathKernels
+{
+    void (*exp)(const float *, float *, int);
+    void (*log)(const float *, float *, int);
+    void (*pow)(const float *, float *, int, float);
+    const char *name;
+};
+
+static MyMathKernels selectKernels()
+{
+    MyMathKernels kernels = { scalarExp, scalarLog, scalarPow, "scalar" };
+#ifdef MYMATH_X86
+    if(MyDispatch::getLevel() >= MyDispatch::AVX2)
+    {
+        MyMathKernels avx2 = { avx2Exp, avx2Log, avx2Pow, "avx2" };
+        kernels = avx2;
+    }
+    else if(MyDispatch::getLevel() >= MyDispatch::SSE2)
+    {
+        // two double lanes per register make pow slower than libm, so only exp and log switch
+        MyMathKernels sse2 = { sse2Exp, sse2Log, scalarPow, "sse2" };
+        kernels = sse2;
+    }
+#endif
+    return kernels;
+}
+
+static const MyMathKernels &getKernels()
+{
+    // selected once, the first call may come from any worker thread
+    static const MyMathKernels kernels = selectKernels();
+    return kernels;
+}
+
+void MyMath::exp(const float *input, float *output, int count)
+{
+    getKernels().exp(input, output, count);
+}
+
+void MyMath::log(const float *input, float *output, int count)
+{
+    getKernels().log(input, output, count);
+}
+
+void MyMath::pow(const float *input, float *output, int count, float exponent)
+{
+    getKernels().pow(input, output, count, exponent);
+}
+
+const char *MyMath::getKernelName()
+{
+    return getKernels().name;
+}
+
+// ----- BENCHMARK --------------------------------------------------------------------------------
+static int64_t orderedBits(float value)
+{
+    // maps floats onto integers so neighbouring floats differ by one
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? (int64_t)INT32_MIN - bits : bits;
+}
+
+static double measureUlp(const std::vector<float> &result, const std::vector<double> &reference)
+{
+    double worst = 0;
+    for(size_t i=0; i<result.size(); i++)
+    {
+        float expected = (float)reference[i];
+        if(std::isnan(expected) && std::isnan(result[i]))
+        {
+            continue;
+        }
+        double distance = std::abs((double)(orderedBits(result[i]) - orderedBits(expected)));
+        worst = std::max(worst, distance);
+    }
+    return worst;
+}
+
+template<class Function>
+static double measureRate(Function function, int count)
+{
+    // best of several runs, in million values per second
+    double best = 0;
+    for(int run=0; run<7; run++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, count / elapsed.count() / 1e6);
+    }
+    return best;
+}
+
+int MyMath::benchmark(std::ostream &out)
+{
+    const int count = 1 << 20;
+    const float powers[] = { 0.4f, 2.2f, 5.0f, 0.0f };
+    std::vector<float> expInput(count), logInput(count), powInput(count);
+    std::vector<float> result(count), libm(count);
+    std::vector<double> reference(count);
+    bool accurate = true;
+
+    for(int i=0; i<count; i++)
+    {
+        expInput[i] = -87.0f + 175.0f * i / count;
+        logInput[i] = std::ldexp(1.0f + (float)(i % 4096) / 4096, i / 4096 % 64 - 32);
+        powInput[i] = 255.0f * i / count;
+    }
+    // the first and last inputs cover the edges, with the last power pow(0, 0) and pow(inf, 0)
+    powInput[count - 1] = std::numeric_limits<float>::infinity();
+
+    out << "kernel " << getKernelName() << ", " << count << " values per run" << std::endl;
+    out << "function     max ulp   kernel Mval/s   libm Mval/s   speedup" << std::endl;
+
+    for(int test=0; test<2 + 4; test++)
+    {
+        std::string name;
+        double rate = 0;
+        double libmRate = 0;
+
+        if(test == 0)
+        {
+            name = "exp";
+            for(int i=0; i<count; i++) reference[i] = std::exp((double)expInput[i]);
+            rate = measureRate([&]() { MyMath::exp(expInput.data(), result.data(), count); }, count);
+            libmRate = measureRate([&]() { scalarExp(expInput.data(), libm.data(), count); }, count);
+        }
+        else if(test == 1)
+        {
+            name = "log";
+            for(int i=0; i<count; i++) reference[i] = std::log((double)logInput[i]);
+            rate = measureRate([&]() { MyMath::log(logInput.data(), result.data(), count); }, count);
+            libmRate = measureRate([&]() { scalarLog(logInput.data(), libm.data(), count); }, count);
+        }
+        else
+        {
+            float power = powers[test - 2];
+            name = "pow " + std::to_string(power).substr(0, 3);
+            for(int i=0; i<count; i++) reference[i] = std::pow((double)powInput[i], (double)power);
+            rate = measureRate([&]() { MyMath::pow(powInput.data(), result.data(), count, power); }, count);
+            libmRate = measureRate([&]() { scalarPow(powInput.data(), libm.data(), count, power); }, count);
+        }
+
+        double ulp = measureUlp(result, reference);
+        accurate = accurate && ulp < 2;
+        out.width(9);
+        out << std::left << name << std::right;
+        out.width(11);
+        out << ulp;
+        out.width(16);
+        out << (int)rate;
+        out.width(14);
+        out << (int)libmRate;
+        out.width(9);
+        out << (int)(rate / libmRate * 10) / 10.0 << "x" << std::endl;
+    }
+
+    return accurate ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef MYMATH_H
+#define MYMATH_H
+
+#include <iostream>
+
+// ----- VECTOR MATH -----
+// polynomial exp, log and pow over float arrays for the per pixel paths of MyTransform, the
+// widest kernel the processor supports is picked on first use; input and output may alias
+namespace MyMath
+{
+    // --- KERNELS ---
+    void exp(const float *input, float *output, int count);
+    void log(const float *input, float *output, int count);
+    void pow(const float *input, float *output, int count, float exponent); // input >= 0
+
+    // --- DIAGNOSTICS ---
+    const char *getKernelName();
+    int benchmark(std::ostream &out);
+}
+
+#endif // MYMATH_H
@@ -0,0 +1,276 @@
+#include "myoperation.h"
+
+#include <cmath>
+
+#include <QLocale>
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyOperation::MyOperation(uint8_t tool, double parameter) :
+    toolSwitch(tool),
+    value(parameter)
+{
+}
+
+MyOperation::~MyOperation()
+{
+    // destructor call goes here
+}
+
+// ----- OPERATION CHAINS -------------------------------------------------------------------------
+QStringList MyOperation::getToolNames()
+{
+    // index matches toolSwitch, entry 0 is unused
+    QStringList names;
+    names << "" << "positive" << "negative" << "shiftleft" << "shiftright" << "scaleup" << "scaledown"
+          << "exp" << "ln" << "power" << "log" << "equalize" << "autocontrast";
+    return names;
+}
+
+QList<MyOperation> MyOperation::parseChain(QString chain, bool *ok)
+{
+    // chains look like "negative,power=0.5,equalize"
+    QList<MyOperation> operations;
+    QStringList names = getToolNames();
+    bool valid = true;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    QStringList steps = chain.split(",", Qt::SkipEmptyParts);
+#else
+    QStringList steps = chain.split(",", QString::SkipEmptyParts);
+#endif
+
+    foreach (QString step, steps)
+    {
+        QString name = step.section("=", 0, 0).trimmed().toLower();
+        int tool = names.indexOf(name);
+
+        if(tool < 1)
+        {
+            valid = false;
+            continue;
+        }
+
+        // a tool with a parameter needs one in its range, otherwise the lookup fills with inf or NaN
+        MyOperation operation(tool, 0);
+        if(step.contains("="))
+        {
+            bool numeric = false;
+            operation.value = step.section("=", 1).trimmed().toDouble(&numeric);
+            valid = valid && numeric;
+        }
+        else if(operation.hasValue())
+        {
+            valid = false;
+        }
+        valid = valid && operation.hasValidValue();
+        operations.append(operation);
+    }
+
+    if(ok)
+    {
+        *ok = valid && !operations.isEmpty();
+    }
+    return operations;
+}
+
+QString MyOperation::toChain(QList<MyOperation> operations)
+{
+    QStringList steps;
+    for(int i=0; i<operations.size(); i++)
+    {
+        steps.append(operations[i].toString());
+    }
+    return steps.join(",");
+}
+
+QString MyOperation::toString()
+{
+    QString name = getToolNames().value(toolSwitch);
+
+    if(!hasValue())
+    {
+        return name;
+    }
+    // the shortest text that reads back to the same double, power=2.2 and not 2.2000000000000002
+#if QT_VERSION >= QT_VERSION_CHECK(5, 7, 0)
+    return name + "=" + QString::number(value, 'g', QLocale::FloatingPointShortest);
+#else
+    return name + "=" + QString::number(value, 'g', 17);
+#endif
+}
+
+bool MyOperation::hasValue()
+{
+    return (toolSwitch >= ShiftLeft && toolSwitch <= ScaleDown) || toolSwitch == Power || toolSwitch == BaseLog ||
+           toolSwitch == AutoContrast;
+}
+
+bool MyOperation::hasValidValue()
+{
+    if(!hasValue())
+    {
+        return true;
+    }
+
+    if(!std::isfinite(value))
+    {
+        return false;
+    }
+
+    switch (toolSwitch){
+    case ShiftLeft:
+    case ShiftRight:
+        return value >= 0 && value < 64 && value == std::floor(value);
+    case ScaleUp:
+    case ScaleDown:
+    case BaseLog:
+        return value > 0;
+    case Power:
+        return value >= 0; // a negative gamma sends intensity 0 to infinity
+    case AutoContrast:
+        return value >= 0 && value < 50; // percent clipped at each end, the cutoffs must not meet
+    default:
+        return true;
+    }
+}
+
+// ----- PROCESSING -------------------------------------------------------------------------------
+void MyOperation::processImage(MyImage &output, MyImage input)
+{
+    switch (toolSwitch){
+    case Negative:
+        output.processNegative(input);
+        break;
+    case ShiftLeft:
+        output.processBitShiftLeft(input, value);
+        break;
+    case ShiftRight:
+        output.processBitShiftRight(input, value);
+        break;
+    case ScaleUp:
+        output.processScaleUp(input, value);
+        break;
+    case ScaleDown:
+        output.processScaleDown(input, value);
+        break;
+    case Exponential:
+        output.processExponential(input);
+        break;
+    case NaturalLog:
+        output.processNaturalLog(input);
+        break;
+    case Power:
+        output.processPowerLaw(input, value);
+        break;
+    case BaseLog:
+        output.processBaseLog(input, value);
+        break;
+    case Equalize:
+        output.processEqualize(input);
+        break;
+    case AutoContrast:
+        output.processAutoContrast(input, value, value);
+        break;
+    default:
+        output.processPositive(input);
+        break;
+    }
+}
+
+void MyOperation::buildLookup(MyImage &engine, QVector<double> transform)
+{
+    // lookup only, transform is the equalization table of the histogram the step sees and
+    // engine holds that histogram
+    switch (toolSwitch){
+    case Negative:
+        engine.buildIntensityLookup(MyTransform::Negative());
+        break;
+    case ShiftLeft:
+        engine.buildIntensityLookup(MyTransform::Shift<MyTransform::Up>(value));
+        break;
+    case ShiftRight:
+        engine.buildIntensityLookup(MyTransform::Shift<MyTransform::Down>(value));
+        break;
+    case ScaleUp:
+        engine.buildIntensityLookup(MyTransform::Scale<MyTransform::Up>(value));
+        break;
+    case ScaleDown:
+        engine.buildIntensityLookup(MyTransform::Scale<MyTransform::Down>(value));
+        break;
+    case Exponential:
+        engine.buildIntensityLookup(MyTransform::Exponential());
+        break;
+    case NaturalLog:
+        engine.buildIntensityLookup(MyTransform::NaturalLog());
+        break;
+    case Power:
+        engine.buildIntensityLookup(MyTransform::Power(value));
+        break;
+    case BaseLog:
+        engine.buildIntensityLookup(MyTransform::BaseLog(value));
+        break;
+    case Equalize:
+        engine.buildIntensityLookup(MyTransform::Equalize(transform.constData()));
+        break;
+    case AutoContrast:
+    {
+        MyStatistics statistics(engine.intensityDistribution);
+        engine.buildIntensityLookup(MyTransform::Stretch(statistics.getPercentile(value), statistics.getPercentile(100 - value)));
+        break;
+    }
+    default:
+        engine.buildIntensityLookup(MyTransform::Positive());
+        break;
+    }
+}
+
+QVector<double> MyOperation::buildChainLookup(QList<MyOperation> operations, QVector<double> distribution, uchar *lookup)
+{
+    // each step only needs the histogram of the previous step, which follows from routing
+    // the bins through the previous lookup, so the whole chain costs O(bins) per operation;
+    // lookup gets the whole chain as one table, the histogram of the result is returned
+    MyImage engine("chain");
+
+    for(uint16_t i=0; i<MyImage::numberBins; i++)
+    {
+        lookup[i] = i;
+    }
+
+    for(int step=0; step<operations.size(); step++)
+    {
+        engine.setIntensityHistogramsFromDistribution(distribution);
+        operations[step].buildLookup(engine, engine.intensityTransform);
+
+        uchar stepLookup[MyImage::numberBins];
+        QVector<double> mapped(MyImage::numberBins, 0);
+
+        int tmp = -1;
+        for(uint16_t bin=0; bin<MyImage::numberBins; bin++)
+        {
+            tmp = round(engine.intensityCalculation.at(bin));
+            stepLookup[bin] = std::max(0, std::min((int)MyImage::maxBin, tmp));
+            mapped[stepLookup[bin]] = mapped.at(stepLookup[bin]) + distribution.at(bin);
+        }
+
+        for(uint16_t i=0; i<MyImage::numberBins; i++)
+        {
+            lookup[i] = stepLookup[lookup[i]];
+        }
+        distribution = mapped;
+    }
+    return distribution;
+}
+
+bool MyOperation::needsDistribution(QList<MyOperation> operations)
+{
+    // only equalization and auto contrast look at the histogram, every other table is fixed by
+    // its parameter
+    for(int step=0; step<operations.size(); step++)
+    {
+        if(operations[step].toolSwitch == Equalize || operations[step].toolSwitch == AutoContrast)
+        {
+            return true;
+        }
+    }
+    return false;
+}
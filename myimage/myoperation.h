@@ -0,0 +1,44 @@
+#ifndef MYOPERATION_H
+#define MYOPERATION_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "myimage.h"
+
+class MyOperation
+{
+
+public:
+    // --- TOOLS ---
+    enum Tool { Positive = 1, Negative, ShiftLeft, ShiftRight, ScaleUp, ScaleDown,
+                Exponential, NaturalLog, Power, BaseLog, Equalize, AutoContrast };
+
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyOperation(uint8_t tool = 1, double parameter = 0);
+    ~MyOperation();
+
+    // --- OPERATION DATA ---
+    uint8_t toolSwitch; // one of Tool, kept numeric for parsing and the toolbox
+    double value; // shift bits, scaling factor, gamma, log base or percent clipped at each end
+
+    // --- OPERATION CHAINS ---
+    static QList<MyOperation> parseChain(QString chain, bool *ok = 0);
+    static QString toChain(QList<MyOperation> operations);
+    QString toString();
+    bool hasValue();
+    bool hasValidValue(); // the value is in the range of the tool, always true without a value
+
+    // --- PROCESSING ---
+    void processImage(MyImage &output, MyImage input);
+    void buildLookup(MyImage &engine, QVector<double> transform);
+    static QVector<double> buildChainLookup(QList<MyOperation> operations, QVector<double> distribution, uchar *lookup);
+    static bool needsDistribution(QList<MyOperation> operations);
+
+private:
+    static QStringList getToolNames();
+
+};
+
+#endif // MYOPERATION_H
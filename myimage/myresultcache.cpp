@@ -0,0 +1,192 @@
+#include "myresultcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#ifdef Q_OS_WIN
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyResultCache::MyResultCache(QString directoryPath, qint64 maxBytes) :
+    directory(directoryPath),
+    maximumBytes(maxBytes),
+    hits(0),
+    misses(0),
+    bytesHeld(0)
+{
+    directory.mkpath(".");
+
+    foreach (QFileInfo entry, directory.entryInfoList(QStringList() << "*.entry", QDir::Files))
+    {
+        bytesHeld += entry.size();
+    }
+}
+
+MyResultCache::~MyResultCache()
+{
+    // destructor call goes here
+}
+
+// ----- KEYS -------------------------------------------------------------------------------------
+QByteArray MyResultCache::keyForFile(QString inputPath, QList<MyOperation> operations, QString outputPath)
+{
+    QFileInfo input(inputPath);
+    if(!input.isFile())
+    {
+        return QByteArray();
+    }
+
+    // toChain spells every step the same way however the chain was typed, and a rewritten
+    // input changes its size or modification time
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(entryVersion));
+    hash.addData(input.canonicalFilePath().toUtf8());
+    hash.addData(QByteArray::number(input.size()));
+    hash.addData(QByteArray::number(input.lastModified().toMSecsSinceEpoch()));
+    hash.addData(MyOperation::toChain(operations).toUtf8());
+    hash.addData(QFileInfo(outputPath).suffix().toLower().toUtf8());
+    return hash.result().toHex();
+}
+
+// ----- ENTRIES ----------------------------------------------------------------------------------
+bool MyResultCache::fetch(QByteArray key, QString outputPath, QVector<double> *histogram)
+{
+    QString entryPath = getEntryPath(key);
+    QFile entry(entryPath);
+    bool found = false;
+
+    if(!key.isEmpty() && entry.open(QIODevice::ReadOnly))
+    {
+        QDataStream stream(&entry);
+        quint32 magic = 0;
+        quint32 version = 0;
+        QVector<double> counts;
+        QByteArray encoded;
+
+        stream >> magic >> version >> counts >> encoded;
+        entry.close();
+
+        if(stream.status() == QDataStream::Ok && magic == entryMagic && version == entryVersion)
+        {
+            QSaveFile output(outputPath);
+            found = output.open(QIODevice::WriteOnly) && output.write(encoded) == encoded.size() && output.commit();
+
+            if(found && histogram)
+            {
+                *histogram = counts;
+            }
+        }
+        else
+        {
+            // written by an older version or cut short, processed again and replaced
+            QFile::remove(entryPath);
+        }
+    }
+
+    if(found)
+    {
+        // a hit makes the entry the most recently used one
+        utime(QFile::encodeName(entryPath).constData(), 0);
+    }
+
+    QMutexLocker locker(&mutex);
+    if(found)
+    {
+        hits++;
+    }
+    else
+    {
+        misses++;
+    }
+    return found;
+}
+
+void MyResultCache::store(QByteArray key, QString outputPath, QVector<double> histogram)
+{
+    QFile output(outputPath);
+    if(key.isEmpty() || !output.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+    QByteArray encoded = output.readAll();
+
+    // readers never see a partial entry, QSaveFile renames it into place once complete
+    QSaveFile entry(getEntryPath(key));
+    if(!entry.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&entry);
+    stream << entryMagic << entryVersion << histogram << encoded;
+    if(stream.status() != QDataStream::Ok || !entry.commit())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    bytesHeld += QFileInfo(getEntryPath(key)).size();
+    if(bytesHeld > maximumBytes)
+    {
+        evict();
+    }
+}
+
+QString MyResultCache::getEntryPath(QByteArray key)
+{
+    return directory.filePath(QString::fromLatin1(key) + ".entry");
+}
+
+void MyResultCache::evict()
+{
+    // other processes may have added entries too, so the directory is counted again; the oldest
+    // entries go until a tenth of the limit is free and the next store does not evict right away
+    QFileInfoList entries = directory.entryInfoList(QStringList() << "*.entry", QDir::Files, QDir::Time | QDir::Reversed);
+
+    bytesHeld = 0;
+    foreach (QFileInfo entry, entries)
+    {
+        bytesHeld += entry.size();
+    }
+
+    qint64 target = maximumBytes - maximumBytes / 10;
+    for(int i=0; i<entries.size() && bytesHeld > target; i++)
+    {
+        if(QFile::remove(entries[i].filePath()))
+        {
+            bytesHeld -= entries[i].size();
+        }
+    }
+}
+
+// ----- COUNTERS ---------------------------------------------------------------------------------
+QString MyResultCache::getDirectory()
+{
+    return directory.path();
+}
+
+uint64_t MyResultCache::getHits()
+{
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+uint64_t MyResultCache::getMisses()
+{
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+qint64 MyResultCache::getBytesHeld()
+{
+    QMutexLocker locker(&mutex);
+    return bytesHeld;
+}
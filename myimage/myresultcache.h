@@ -0,0 +1,57 @@
+#ifndef MYRESULTCACHE_H
+#define MYRESULTCACHE_H
+
+#include <stdint.h>
+#include <QByteArray>
+#include <QDir>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "myoperation.h"
+
+// ----- RESULT CACHE -----
+// persistent cache of encoded output images and their histograms, one file per entry. an entry
+// is found by the identity of the input file (path, size and modification time), the canonical
+// operation chain and the output format, so a hit neither decodes nor processes anything.
+// recency is the modification time of the entry file, the least recently used entries are
+// removed once the directory grows past maxBytes; several processes may share one directory
+class MyResultCache
+{
+
+public:
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyResultCache(QString directoryPath, qint64 maxBytes);
+    ~MyResultCache();
+
+    // --- KEYS ---
+    static QByteArray keyForFile(QString inputPath, QList<MyOperation> operations, QString outputPath); // empty without input
+
+    // --- ENTRIES ---
+    bool fetch(QByteArray key, QString outputPath, QVector<double> *histogram = 0); // writes outputPath on a hit
+    void store(QByteArray key, QString outputPath, QVector<double> histogram); // outputPath as just written
+
+    // --- COUNTERS ---
+    QString getDirectory();
+    uint64_t getHits();
+    uint64_t getMisses();
+    qint64 getBytesHeld();
+
+private:
+    QString getEntryPath(QByteArray key);
+    void evict();
+
+    static const quint32 entryMagic = 0x4d595243; // "MYRC"
+    static const quint32 entryVersion = 1;
+
+    QDir directory;
+    qint64 maximumBytes;
+    QMutex mutex; // guards the counters below, entries are replaced atomically on disk
+    uint64_t hits;
+    uint64_t misses;
+    qint64 bytesHeld; // as seen by this process, recounted on every eviction
+
+};
+
+#endif // MYRESULTCACHE_H
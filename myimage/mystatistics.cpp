@@ -0,0 +1,81 @@
+#include "mystatistics.h"
+
+#include <algorithm>
+#include <math.h>
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyStatistics::MyStatistics(QVector<double> distribution) :
+    count(0),
+    minimum(0),
+    maximum(0),
+    mean(0),
+    variance(0),
+    standardDeviation(0),
+    median(0),
+    entropy(0),
+    dynamicRange(0)
+{
+    int bins = distribution.size();
+    int lowest = -1;
+    int highest = -1;
+    double sum = 0;
+
+    cumulative.fill(0, bins);
+    for(int i=0; i<bins; i++)
+    {
+        count += distribution[i];
+        sum += distribution[i] * i;
+        cumulative[i] = count;
+
+        if(distribution[i] > 0)
+        {
+            lowest = lowest < 0 ? i : lowest;
+            highest = i;
+        }
+    }
+
+    if(count <= 0)
+    {
+        count = 0;
+        return;
+    }
+
+    minimum = lowest;
+    maximum = highest;
+    dynamicRange = highest - lowest;
+    mean = sum / count;
+
+    // second pass around the mean, one pass sums of squares lose precision on large images
+    double squares = 0;
+    for(int i=lowest; i<=highest; i++)
+    {
+        if(distribution[i] > 0)
+        {
+            double probability = distribution[i] / count;
+            squares += distribution[i] * (i - mean) * (i - mean);
+            entropy -= probability * log2(probability);
+        }
+    }
+
+    variance = squares / count;
+    standardDeviation = sqrt(variance);
+    median = getPercentile(50);
+}
+
+MyStatistics::~MyStatistics()
+{
+    // destructor call goes here
+}
+
+// ----- STATISTICS -------------------------------------------------------------------------------
+double MyStatistics::getPercentile(double percent)
+{
+    if(count <= 0)
+    {
+        return 0;
+    }
+
+    // the first intensity with at least the requested share of the pixels at or below it
+    double rank = std::max(1.0, ceil(std::min(100.0, std::max(0.0, percent)) / 100 * count));
+    return std::lower_bound(cumulative.begin(), cumulative.end(), rank) - cumulative.begin();
+}
@@ -0,0 +1,36 @@
+#ifndef MYSTATISTICS_H
+#define MYSTATISTICS_H
+
+#include <QVector>
+
+// ----- IMAGE STATISTICS -----
+// summary of an intensity histogram, bin i counting the pixels of intensity i; every value is
+// derived from the counts alone, 256 bins for 8 bit and 65536 for 16 bit images, so no pixel
+// is read again. an empty histogram gives a count of 0 and all other values 0
+class MyStatistics
+{
+
+public:
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyStatistics(QVector<double> distribution = QVector<double>());
+    ~MyStatistics();
+
+    // --- STATISTICS ---
+    double count; // pixels in the histogram, the region of interest when one is set
+    double minimum;
+    double maximum;
+    double mean;
+    double variance; // of the population
+    double standardDeviation;
+    double median;
+    double entropy; // Shannon entropy in bits per pixel
+    double dynamicRange; // intensity levels between the darkest and the brightest pixel
+
+    double getPercentile(double percent); // nearest rank, 0 is the minimum and 100 the maximum
+
+private:
+    QVector<double> cumulative; // pixels at or below each intensity
+
+};
+
+#endif // MYSTATISTICS_H
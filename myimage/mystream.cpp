@@ -0,0 +1,454 @@
+#include "mystream.h"
+
+const uint32_t MyStream::stripRows;
+const tmsize_t MyStream::maxChunkBytes;
+const uint64_t MyStream::bigTiffBytes;
+
+// ----- CONSTRUCTOR / DESTRUCTOR -----------------------------------------------------------------
+MyStream::MyStream() :
+    counts(MyImage::numberBins, 0),
+    rescaled(false)
+{
+    for(uint16_t i=0; i<MyImage::numberBins; i++)
+    {
+        lookup[i] = i;
+        levels[i] = i;
+    }
+}
+
+MyStream::~MyStream()
+{
+    // destructor call goes here
+}
+
+// ----- PROCESSING -------------------------------------------------------------------------------
+bool MyStream::isStreamable(QString filePath)
+{
+    QString suffix = QFileInfo(filePath).suffix().toLower();
+    return suffix == "pgm" || suffix == "tif" || suffix == "tiff";
+}
+
+bool MyStream::process(QString inputPath, QString outputPath, QList<MyOperation> operations)
+{
+    // pass one only builds the histogram, pass two applies the composed lookup strip by strip,
+    // so at most one strip of the source is held in memory at any time
+    bool isPGM = QFileInfo(inputPath).suffix().toLower() == "pgm";
+
+    if(!isStreamable(inputPath))
+    {
+        error = "unsupported stream format: " + inputPath;
+        return false;
+    }
+
+    std::fill(counts.begin(), counts.end(), 0);
+
+    if(!(isPGM ? scanPGM(inputPath) : scanTIFF(inputPath)))
+    {
+        return false;
+    }
+
+    buildLookup(operations);
+
+    return isPGM ? applyPGM(inputPath, outputPath) : applyTIFF(inputPath, outputPath);
+}
+
+// ----- RESULTS ----------------------------------------------------------------------------------
+QVector<double> MyStream::getSourceDistribution()
+{
+    QVector<double> distribution(MyImage::numberBins, 0);
+    for(uint16_t i=0; i<MyImage::numberBins; i++)
+    {
+        distribution[i] = counts[i];
+    }
+    return distribution;
+}
+
+QVector<double> MyStream::getResultDistribution()
+{
+    return resultDistribution;
+}
+
+QString MyStream::getError()
+{
+    return error;
+}
+
+// ----- LOOKUP -----------------------------------------------------------------------------------
+void MyStream::buildLookup(QList<MyOperation> operations)
+{
+    resultDistribution = MyOperation::buildChainLookup(operations, getSourceDistribution(), lookup);
+}
+
+void MyStream::countStrip(const uchar *strip, uint32_t rows, uint32_t cols, uint32_t stride)
+{
+    const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
+
+    for(uint32_t row=0; row<rows; row++)
+    {
+        kernels.countHistogram(strip + (uint64_t)row * stride, cols, counts.data());
+    }
+}
+
+void MyStream::applyStrip(uchar *strip, uint64_t size)
+{
+    MyDispatch::getKernels().applyLookup(strip, strip, size, lookup);
+}
+
+// ----- PGM --------------------------------------------------------------------------------------
+bool MyStream::readPGMHeader(QFile &file, uint32_t &cols, uint32_t &rows)
+{
+    // binary greymap: "P5" width height maxval, separated by whitespace, '#' starts a comment
+    QList<QByteArray> tokens;
+    char c = 0;
+    QByteArray token;
+
+    while(tokens.size() < 4 && file.getChar(&c))
+    {
+        if(c == '#')
+        {
+            file.readLine();
+        }
+        else if(isspace((unsigned char)c))
+        {
+            if(!token.isEmpty())
+            {
+                tokens.append(token);
+                token.clear();
+            }
+        }
+        else
+        {
+            token.append(c);
+        }
+    }
+
+    // exactly one whitespace character ends the header and has been consumed above
+    int maxval = tokens.size() < 4 ? 0 : tokens[3].toInt();
+    if(tokens.size() < 4 || tokens[0] != "P5" || maxval <= 0 || maxval > MyImage::maxBin)
+    {
+        error = "only 8 bit binary PGM files can be streamed: " + file.fileName();
+        return false;
+    }
+
+    // the output is always written with maxval 255, so smaller ranges are stretched like imread does
+    rescaled = maxval != MyImage::maxBin;
+    for(uint16_t i=0; i<MyImage::numberBins; i++)
+    {
+        levels[i] = std::min<int>(MyImage::maxBin, (i * MyImage::maxBin + maxval / 2) / maxval);
+    }
+
+    cols = tokens[1].toUInt();
+    rows = tokens[2].toUInt();
+    return cols > 0 && rows > 0;
+}
+
+void MyStream::rescaleStrip(uchar *strip, uint64_t size)
+{
+    if(rescaled)
+    {
+        MyDispatch::getKernels().applyLookup(strip, strip, size, levels);
+    }
+}
+
+bool MyStream::scanPGM(QString inputPath)
+{
+    QFile file(inputPath);
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+
+    if(!file.open(QIODevice::ReadOnly) || !readPGMHeader(file, cols, rows))
+    {
+        error = error.isEmpty() ? "cannot read " + inputPath : error;
+        return false;
+    }
+
+    std::vector<uchar> strip((uint64_t)stripRows * cols);
+
+    for(uint32_t row=0; row<rows; row+=stripRows)
+    {
+        uint32_t count = std::min(stripRows, rows - row);
+        uint64_t bytes = (uint64_t)count * cols;
+
+        if(file.read((char *)strip.data(), bytes) != (qint64)bytes)
+        {
+            error = "truncated PGM file: " + inputPath;
+            return false;
+        }
+        rescaleStrip(strip.data(), bytes);
+        countStrip(strip.data(), count, cols, cols);
+    }
+    return true;
+}
+
+bool MyStream::applyPGM(QString inputPath, QString outputPath)
+{
+    QFile input(inputPath);
+    QFile output(outputPath);
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+
+    if(!input.open(QIODevice::ReadOnly) || !readPGMHeader(input, cols, rows))
+    {
+        error = error.isEmpty() ? "cannot read " + inputPath : error;
+        return false;
+    }
+
+    if(!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        error = "cannot write " + outputPath;
+        return false;
+    }
+
+    output.write(QString("P5\n%1 %2\n%3\n").arg(cols).arg(rows).arg((int)MyImage::maxBin).toLatin1());
+
+    std::vector<uchar> strip((uint64_t)stripRows * cols);
+
+    for(uint32_t row=0; row<rows; row+=stripRows)
+    {
+        uint32_t count = std::min(stripRows, rows - row);
+        uint64_t bytes = (uint64_t)count * cols;
+
+        if(input.read((char *)strip.data(), bytes) != (qint64)bytes)
+        {
+            error = "truncated PGM file: " + inputPath;
+            return false;
+        }
+
+        rescaleStrip(strip.data(), bytes);
+        applyStrip(strip.data(), bytes);
+
+        if(output.write((const char *)strip.data(), bytes) != (qint64)bytes)
+        {
+            error = "cannot write " + outputPath;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----- TIFF -------------------------------------------------------------------------------------
+bool MyStream::openTIFF(QString inputPath, TIFF *&tiff)
+{
+    uint16_t bitsPerSample = 0;
+    uint16_t samplesPerPixel = 1;
+
+    tiff = TIFFOpen(inputPath.toLocal8Bit().constData(), "r");
+    if(!tiff)
+    {
+        error = "cannot read " + inputPath;
+        return false;
+    }
+
+    TIFFGetField(tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+
+    if(bitsPerSample != 8 || samplesPerPixel != 1)
+    {
+        error = "only 8 bit single channel TIFF files can be streamed: " + inputPath;
+        TIFFClose(tiff);
+        tiff = 0;
+        return false;
+    }
+    return true;
+}
+
+bool MyStream::checkTIFFLayout(QString inputPath, TIFF *tiff, tmsize_t &chunkSize, bool &scanlines)
+{
+    // one strip or tile is held at a time, strips beyond the cap are read scanline by scanline
+    // instead, tiles have no such fallback and are refused
+    bool tiled = TIFFIsTiled(tiff);
+    chunkSize = tiled ? TIFFTileSize(tiff) : TIFFStripSize(tiff);
+    scanlines = !tiled && chunkSize > maxChunkBytes;
+
+    if(chunkSize <= 0)
+    {
+        error = "cannot decode " + inputPath;
+        return false;
+    }
+
+    if(tiled && chunkSize > maxChunkBytes)
+    {
+        error = QString("TIFF tiles above %1 MiB cannot be streamed: ").arg(maxChunkBytes >> 20) + inputPath;
+        return false;
+    }
+
+    if(scanlines)
+    {
+        chunkSize = TIFFScanlineSize(tiff);
+    }
+    return true;
+}
+
+bool MyStream::scanTIFF(QString inputPath)
+{
+    TIFF *tiff = 0;
+    if(!openTIFF(inputPath, tiff))
+    {
+        return false;
+    }
+
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+    TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &cols);
+    TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &rows);
+
+    bool tiled = TIFFIsTiled(tiff);
+    bool scanlines = false;
+    tmsize_t chunkSize = 0;
+    if(!checkTIFFLayout(inputPath, tiff, chunkSize, scanlines))
+    {
+        TIFFClose(tiff);
+        return false;
+    }
+
+    uint32_t chunkCount = scanlines ? rows : tiled ? TIFFNumberOfTiles(tiff) : TIFFNumberOfStrips(tiff);
+    std::vector<uchar> chunk(chunkSize);
+
+    uint32_t tileCols = 0;
+    uint32_t tileRows = 0;
+    if(tiled)
+    {
+        TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileCols);
+        TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tileRows);
+    }
+
+    bool valid = true;
+    for(uint32_t i=0; i<chunkCount && valid; i++)
+    {
+        if(tiled)
+        {
+            valid = TIFFReadEncodedTile(tiff, i, chunk.data(), chunkSize) >= 0;
+
+            // edge tiles are padded, only count the pixels inside the image
+            uint32_t tilesAcross = (cols + tileCols - 1) / tileCols;
+            uint32_t left = (i % tilesAcross) * tileCols;
+            uint32_t top = (i / tilesAcross) * tileRows;
+            countStrip(chunk.data(), std::min(tileRows, rows - top), std::min(tileCols, cols - left), tileCols);
+        }
+        else if(scanlines)
+        {
+            valid = TIFFReadScanline(tiff, chunk.data(), i, 0) >= 0;
+            countStrip(chunk.data(), 1, valid ? cols : 0, 0);
+        }
+        else
+        {
+            tmsize_t bytes = TIFFReadEncodedStrip(tiff, i, chunk.data(), chunkSize);
+            valid = bytes >= 0;
+            countStrip(chunk.data(), 1, valid ? bytes : 0, 0);
+        }
+    }
+    TIFFClose(tiff);
+
+    if(!valid)
+    {
+        error = "cannot decode " + inputPath;
+    }
+    return valid;
+}
+
+bool MyStream::applyTIFF(QString inputPath, QString outputPath)
+{
+    TIFF *input = 0;
+    if(!openTIFF(inputPath, input))
+    {
+        return false;
+    }
+
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+    TIFFGetField(input, TIFFTAG_IMAGEWIDTH, &cols);
+    TIFFGetField(input, TIFFTAG_IMAGELENGTH, &rows);
+
+    bool tiled = TIFFIsTiled(input);
+    bool scanlines = false;
+    tmsize_t chunkSize = 0;
+    if(!checkTIFFLayout(inputPath, input, chunkSize, scanlines))
+    {
+        TIFFClose(input);
+        return false;
+    }
+
+    // classic TIFF stores 32 bit offsets, large outputs are written as BigTIFF
+    bool big = (uint64_t)cols * rows >= bigTiffBytes;
+    TIFF *output = TIFFOpen(outputPath.toLocal8Bit().constData(), big ? "w8" : "w");
+    if(!output)
+    {
+        error = "cannot write " + outputPath;
+        TIFFClose(input);
+        return false;
+    }
+
+    // the lookup is a point operation, so the output keeps the strip or tile layout of the input,
+    // except for oversized strips which are rewritten with stripRows rows each
+    uint32_t value32 = 0;
+    uint16_t value16 = 0;
+
+    TIFFSetField(output, TIFFTAG_IMAGEWIDTH, cols);
+    TIFFSetField(output, TIFFTAG_IMAGELENGTH, rows);
+    TIFFSetField(output, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(output, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(output, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFGetFieldDefaulted(input, TIFFTAG_PHOTOMETRIC, &value16);
+    TIFFSetField(output, TIFFTAG_PHOTOMETRIC, value16);
+    TIFFGetFieldDefaulted(input, TIFFTAG_COMPRESSION, &value16);
+    TIFFSetField(output, TIFFTAG_COMPRESSION, value16);
+    if(TIFFGetField(input, TIFFTAG_PREDICTOR, &value16))
+    {
+        TIFFSetField(output, TIFFTAG_PREDICTOR, value16);
+    }
+
+    if(tiled)
+    {
+        TIFFGetField(input, TIFFTAG_TILEWIDTH, &value32);
+        TIFFSetField(output, TIFFTAG_TILEWIDTH, value32);
+        TIFFGetField(input, TIFFTAG_TILELENGTH, &value32);
+        TIFFSetField(output, TIFFTAG_TILELENGTH, value32);
+    }
+    else if(scanlines)
+    {
+        TIFFSetField(output, TIFFTAG_ROWSPERSTRIP, stripRows);
+    }
+    else
+    {
+        TIFFGetFieldDefaulted(input, TIFFTAG_ROWSPERSTRIP, &value32);
+        TIFFSetField(output, TIFFTAG_ROWSPERSTRIP, value32);
+    }
+
+    uint32_t chunkCount = scanlines ? rows : tiled ? TIFFNumberOfTiles(input) : TIFFNumberOfStrips(input);
+    std::vector<uchar> chunk(chunkSize);
+
+    bool valid = true;
+    for(uint32_t i=0; i<chunkCount && valid; i++)
+    {
+        if(scanlines)
+        {
+            valid = TIFFReadScanline(input, chunk.data(), i, 0) >= 0;
+            if(valid)
+            {
+                applyStrip(chunk.data(), cols);
+                valid = TIFFWriteScanline(output, chunk.data(), i, 0) >= 0;
+            }
+            continue;
+        }
+
+        tmsize_t bytes = tiled ? TIFFReadEncodedTile(input, i, chunk.data(), chunkSize)
+                               : TIFFReadEncodedStrip(input, i, chunk.data(), chunkSize);
+        valid = bytes >= 0;
+
+        if(valid)
+        {
+            applyStrip(chunk.data(), bytes);
+            valid = (tiled ? TIFFWriteEncodedTile(output, i, chunk.data(), bytes)
+                           : TIFFWriteEncodedStrip(output, i, chunk.data(), bytes)) >= 0;
+        }
+    }
+
+    TIFFClose(input);
+    TIFFClose(output);
+
+    if(!valid)
+    {
+        error = "cannot convert " + inputPath + " to " + outputPath;
+    }
+    return valid;
+}
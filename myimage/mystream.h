@@ -0,0 +1,64 @@
+#ifndef MYSTREAM_H
+#define MYSTREAM_H
+
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QVector>
+
+#include <tiffio.h>
+
+#include "myimage.h"
+#include "myoperation.h"
+
+class MyStream
+{
+
+public:
+    // --- STREAM SETTINGS ---
+    static const uint32_t stripRows = 64; // rows per strip for formats without native strips
+    static const tmsize_t maxChunkBytes = 64 * 1024 * 1024; // larger TIFF strips go by scanline
+    static const uint64_t bigTiffBytes = 3ULL * 1024 * 1024 * 1024; // BigTIFF output from here on
+
+    // --- CONSTRUCTOR / DESTRUCTOR ---
+    MyStream();
+    ~MyStream();
+
+    // --- PROCESSING ---
+    static bool isStreamable(QString filePath);
+    bool process(QString inputPath, QString outputPath, QList<MyOperation> operations);
+
+    // --- RESULTS ---
+    QVector<double> getSourceDistribution();
+    QVector<double> getResultDistribution();
+    QString getError();
+
+private:
+    // --- LOOKUP ---
+    void buildLookup(QList<MyOperation> operations);
+    void countStrip(const uchar *strip, uint32_t rows, uint32_t cols, uint32_t stride);
+    void applyStrip(uchar *strip, uint64_t size);
+
+    // --- PGM ---
+    bool readPGMHeader(QFile &file, uint32_t &cols, uint32_t &rows);
+    void rescaleStrip(uchar *strip, uint64_t size);
+    bool scanPGM(QString inputPath);
+    bool applyPGM(QString inputPath, QString outputPath);
+
+    // --- TIFF ---
+    bool openTIFF(QString inputPath, TIFF *&tiff);
+    bool checkTIFFLayout(QString inputPath, TIFF *tiff, tmsize_t &chunkSize, bool &scanlines);
+    bool scanTIFF(QString inputPath);
+    bool applyTIFF(QString inputPath, QString outputPath);
+
+    // --- STREAM STATE ---
+    std::vector<uint64_t> counts; // pass one histogram of the source
+    QVector<double> resultDistribution; // histogram of the output, derived from counts
+    uchar lookup[MyImage::numberBins]; // whole chain composed into one table
+    uchar levels[MyImage::numberBins]; // PGM levels below 255 stretched onto the full range
+    bool rescaled; // levels is not the identity
+    QString error;
+
+};
+
+#endif // MYSTREAM_H
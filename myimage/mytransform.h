@@ -0,0 +1,193 @@
+#ifndef MYTRANSFORM_H
+#define MYTRANSFORM_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <opencv2/core/core.hpp>
+
+#include "mydispatch.h"
+#include "mymath.h"
+
+// ----- TRANSFORM FAMILY -----
+// one functor per intensity transform, evaluated per bin for 8 bit lookups and per pixel for
+// 16 bit and float images, every call is inlined into the loop that instantiates it
+namespace MyTransform
+{
+    enum Direction { Up, Down };
+
+    struct Positive
+    {
+        template<class V> V operator()(V i) const { return i; }
+    };
+
+    struct Negative
+    {
+        double maximum; // largest intensity of the pixel type
+        Negative(double top = 255) : maximum(top) {}
+        template<class V> V operator()(V i) const { return V(maximum) - i; }
+    };
+
+    template<Direction D>
+    struct Shift
+    {
+        unsigned int bits;
+        Shift(double value) : bits((unsigned int)value) {}
+        template<class V> V operator()(V i) const
+        {
+            return D == Up ? V((unsigned long long)i << bits) : V((unsigned long long)i >> bits);
+        }
+    };
+
+    template<Direction D>
+    struct Scale
+    {
+        double factor;
+        Scale(double value) : factor(value) {}
+        template<class V> V operator()(V i) const { return D == Up ? i * V(factor) : i / V(factor); }
+    };
+
+    struct Exponential
+    {
+        double range; // input that maps to exp(1)
+        Exponential(double top = 255) : range(top) {}
+        template<class V> V operator()(V i) const { return std::exp(V(1.0) * i / V(range)); }
+    };
+
+    struct NaturalLog
+    {
+        template<class V> V operator()(V i) const { return std::log(V(1.0) + i); }
+    };
+
+    struct Power
+    {
+        double gamma;
+        Power(double value) : gamma(value) {}
+        template<class V> V operator()(V i) const { return std::pow(i, V(gamma)); }
+    };
+
+    struct BaseLog
+    {
+        double denominator; // log(base + 1), hoisted out of the pixel loop
+        BaseLog(double base) : denominator(std::log(base + 1)) {}
+        template<class V> V operator()(V i) const { return std::log(i + V(1)) / V(denominator); }
+    };
+
+    struct Equalize
+    {
+        const double *transform; // MyImage::intensityTransform of the source, lookup domain only
+        Equalize(const double *table) : transform(table) {}
+        template<class V> V operator()(V i) const { return transform ? V(transform[(int)i]) : i; }
+    };
+
+    struct Stretch
+    {
+        double low; // intensity mapped to 0
+        double high; // intensity mapped to 255, so the table spans 0 to 255 and rebinning keeps it
+        Stretch(double from, double to) : low(from), high(to) {}
+        template<class V> V operator()(V i) const
+        {
+            return high > low ? V(std::min(255.0, std::max(0.0, (i - low) * 255.0 / (high - low)))) : i;
+        }
+    };
+
+    // row evaluation for the direct path, the transcendental transforms go through the vector
+    // kernels of MyMath instead of one libm call per pixel
+    template<class Op>
+    void evaluateRow(const Op &op, float *values, int count)
+    {
+        for(int i=0; i<count; i++)
+        {
+            values[i] = op(values[i]);
+        }
+    }
+
+    inline void evaluateRow(const Exponential &op, float *values, int count)
+    {
+        for(int i=0; i<count; i++)
+        {
+            values[i] /= float(op.range);
+        }
+        MyMath::exp(values, values, count);
+    }
+
+    inline void evaluateRow(const NaturalLog &, float *values, int count)
+    {
+        for(int i=0; i<count; i++)
+        {
+            values[i] += 1.0f;
+        }
+        MyMath::log(values, values, count);
+    }
+
+    inline void evaluateRow(const Power &op, float *values, int count)
+    {
+        MyMath::pow(values, values, count, float(op.gamma));
+    }
+
+    inline void evaluateRow(const BaseLog &op, float *values, int count)
+    {
+        evaluateRow(NaturalLog(), values, count);
+        for(int i=0; i<count; i++)
+        {
+            values[i] /= float(op.denominator);
+        }
+    }
+
+    // direct evaluation for pixel types where a lookup table is impractical, pixels are brought
+    // into the 0..255 domain of the lookup transforms and evaluated in float
+    template<class Op>
+    void evaluateDirectRow(const cv::Mat &source, int row, float *result, const Op &op)
+    {
+        const MyDispatch::Kernels &kernels = MyDispatch::getKernels();
+
+        if(source.depth() == CV_16U)
+        {
+            kernels.convert16U(source.ptr<uint16_t>(row), result, source.cols, 255.0f / 65535.0f);
+        }
+        else
+        {
+            kernels.convert32F(source.ptr<float>(row), result, source.cols, 255.0f);
+        }
+        evaluateRow(op, result, source.cols);
+    }
+
+    // evaluates op over source and stretches the result over 0..top into target the way
+    // cv::normalize with NORM_MINMAX does, but through a single float row: the first pass finds
+    // the range, the second evaluates again and writes; target may be source itself
+    template<class Op>
+    bool applyNormalized(const cv::Mat &source, cv::Mat &target, Op op, double top)
+    {
+        if(source.depth() != CV_16U && source.depth() != CV_32F)
+        {
+            return false;
+        }
+
+        cv::Mat values(1, source.cols, CV_32F);
+        double low = DBL_MAX;
+        double high = -DBL_MAX;
+
+        for(int row=0; row < source.rows; row++)
+        {
+            double rowLow = 0;
+            double rowHigh = 0;
+            evaluateDirectRow(source, row, values.ptr<float>(), op);
+            cv::minMaxLoc(values, &rowLow, &rowHigh);
+            low = std::min(low, rowLow);
+            high = std::max(high, rowHigh);
+        }
+
+        double scale = top * (high - low > DBL_EPSILON ? 1.0 / (high - low) : 0);
+        double shift = -low * scale;
+
+        for(int row=0; row < source.rows; row++)
+        {
+            cv::Mat result = target.row(row);
+            evaluateDirectRow(source, row, values.ptr<float>(), op);
+            values.convertTo(result, target.type(), scale, shift);
+        }
+        return true;
+    }
+}
+
+#endif // MYTRANSFORM_H
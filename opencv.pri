@@ -0,0 +1,41 @@
+# OpenCV 3.2 or later, linked with only the modules MyImage uses: core, imgproc and imgcodecs.
+# OPENCV_DIR overrides the install location, e.g. qmake OPENCV_DIR=/usr/local; without it Linux
+# builds take the flags of the opencv4 or opencv pkg-config package, which may list more modules
+
+macx {
+    isEmpty(OPENCV_DIR): OPENCV_DIR = /opt/local
+
+    INCLUDEPATH += $$OPENCV_DIR/include
+    LIBS += -L$$OPENCV_DIR/lib \
+        -lopencv_core \
+        -lopencv_imgproc \
+        -lopencv_imgcodecs
+}
+
+win32 {
+    isEmpty(OPENCV_DIR): OPENCV_DIR = "C:\OpenCV-3.2.0\opencv"
+
+    INCLUDEPATH += $$OPENCV_DIR/build/include
+    LIBS += -L$$OPENCV_DIR/sources/build/lib/Release \
+        -lopencv_core320 \
+        -lopencv_imgproc320 \
+        -lopencv_imgcodecs320
+}
+
+unix:!macx {
+    isEmpty(OPENCV_DIR) {
+        # the distribution packages, OpenCV 4 installs its pkg-config file as opencv4
+        CONFIG += link_pkgconfig
+        packagesExist(opencv4): PKGCONFIG += opencv4
+        else: PKGCONFIG += opencv
+    } else {
+        # OpenCV 4 keeps its headers one level down, in include/opencv4
+        exists($$OPENCV_DIR/include/opencv4): INCLUDEPATH += $$OPENCV_DIR/include/opencv4
+        else: INCLUDEPATH += $$OPENCV_DIR/include
+
+        LIBS += -L$$OPENCV_DIR/lib \
+            -lopencv_core \
+            -lopencv_imgproc \
+            -lopencv_imgcodecs
+    }
+}
@@ -0,0 +1,277 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <exception>
+#include <string>
+
+#include "myimage.h"
+#include "myoperation.h"
+
+// ----- BUFFERS ----------------------------------------------------------------------------------
+// a 2D uint8, uint16 or float32 buffer seen as a cv::Mat header over the caller's memory, rows
+// may be padded but the pixels of a row have to be adjacent
+class MyPythonBuffer
+{
+public:
+    MyPythonBuffer() :
+        acquired(false)
+    {
+    }
+
+    ~MyPythonBuffer()
+    {
+        if(acquired)
+        {
+            PyBuffer_Release(&view);
+        }
+    }
+
+    bool acquire(PyObject *object, bool writable)
+    {
+        int flags = PyBUF_STRIDES | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+        if(PyObject_GetBuffer(object, &view, flags) != 0)
+        {
+            return false;
+        }
+        acquired = true;
+
+        const char *format = view.format ? view.format : "B";
+        if(*format == '@' || *format == '=' || *format == '<')
+        {
+            format++;
+        }
+
+        if(std::string(format) == "B")
+        {
+            type = CV_8UC1;
+        }
+        else if(std::string(format) == "H")
+        {
+            type = CV_16UC1;
+        }
+        else if(std::string(format) == "f")
+        {
+            type = CV_32FC1;
+        }
+        else
+        {
+            PyErr_SetString(PyExc_TypeError, "expected a uint8, uint16 or float32 array");
+            return false;
+        }
+
+        if(view.ndim != 2 || view.strides[1] != view.itemsize || view.strides[0] < view.shape[1] * view.itemsize ||
+           view.strides[0] % view.itemsize != 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "expected a 2D array with contiguous rows");
+            return false;
+        }
+        return true;
+    }
+
+    cv::Mat getMatrix()
+    {
+        return cv::Mat(view.shape[0], view.shape[1], type, view.buf, view.strides[0]);
+    }
+
+    bool matches(MyPythonBuffer &other)
+    {
+        return type == other.type && view.shape[0] == other.view.shape[0] && view.shape[1] == other.view.shape[1];
+    }
+
+    Py_buffer view;
+    bool acquired;
+    int type;
+};
+
+static PyObject *allocateLike(PyObject *source)
+{
+    // numpy is only needed when the caller does not pass an output array
+    PyObject *numpy = PyImport_ImportModule("numpy");
+    if(!numpy)
+    {
+        return 0;
+    }
+    PyObject *result = PyObject_CallMethod(numpy, "empty_like", "O", source);
+    Py_DECREF(numpy);
+    return result;
+}
+
+// ----- TRANSFORMS -------------------------------------------------------------------------------
+static PyObject *runOperation(PyObject *sourceObject, PyObject *targetObject, MyOperation operation)
+{
+    MyPythonBuffer source;
+    if(!source.acquire(sourceObject, false))
+    {
+        return 0;
+    }
+    if(MyOperation::needsDistribution(QList<MyOperation>() << operation) && source.type != CV_8UC1)
+    {
+        PyErr_SetString(PyExc_TypeError, "equalize and auto_contrast need a uint8 array");
+        return 0;
+    }
+
+    if(!targetObject || targetObject == Py_None)
+    {
+        targetObject = allocateLike(sourceObject);
+    }
+    else
+    {
+        Py_INCREF(targetObject);
+    }
+
+    MyPythonBuffer target;
+    if(!targetObject || !target.acquire(targetObject, true) || !source.matches(target))
+    {
+        if(targetObject && !PyErr_Occurred())
+        {
+            PyErr_SetString(PyExc_ValueError, "out must have the shape and dtype of the input");
+        }
+        Py_XDECREF(targetObject);
+        return 0;
+    }
+
+    // both buffers stay exported until they are released, so no other Python thread can resize
+    // the arrays while the GIL is dropped; passing the input as out works in place
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        MyImage input("input");
+        MyImage output("output");
+        input.setImageFromMatrix(source.getMatrix());
+        output.setImageFromMatrix(target.getMatrix(), false);
+        operation.processImage(output, input);
+    }
+    catch(const std::exception &exception)
+    {
+        error = exception.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if(!error.empty())
+    {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        Py_DECREF(targetObject);
+        return 0;
+    }
+    return targetObject;
+}
+
+template<int tool>
+static PyObject *transform(PyObject *, PyObject *args, PyObject *kwargs)
+{
+    MyOperation operation(tool, 0);
+    PyObject *source = 0;
+    PyObject *target = 0;
+
+    if(operation.hasValue())
+    {
+        static const char *keywords[] = { "image", "value", "out", 0 };
+        if(!PyArg_ParseTupleAndKeywords(args, kwargs, "Od|O", (char **)keywords, &source, &operation.value, &target))
+        {
+            return 0;
+        }
+        if(!operation.hasValidValue())
+        {
+            PyErr_SetString(PyExc_ValueError, "value is out of range for this transform");
+            return 0;
+        }
+    }
+    else
+    {
+        static const char *keywords[] = { "image", "out", 0 };
+        if(!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O", (char **)keywords, &source, &target))
+        {
+            return 0;
+        }
+    }
+    return runOperation(source, target, operation);
+}
+
+// ----- HISTOGRAMS -------------------------------------------------------------------------------
+static PyObject *histogram(PyObject *, PyObject *args)
+{
+    PyObject *sourceObject = 0;
+    if(!PyArg_ParseTuple(args, "O", &sourceObject))
+    {
+        return 0;
+    }
+
+    MyPythonBuffer source;
+    if(!source.acquire(sourceObject, false))
+    {
+        return 0;
+    }
+    if(source.type != CV_8UC1)
+    {
+        PyErr_SetString(PyExc_TypeError, "histogram needs a uint8 array");
+        return 0;
+    }
+
+    // an exception must not cross Py_END_ALLOW_THREADS, it would leave the GIL released
+    QVector<double> counts;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        MyImage input("input");
+        input.setImageFromMatrix(source.getMatrix());
+        counts = input.intensityDistribution;
+    }
+    catch(const std::exception &exception)
+    {
+        error = exception.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if(!error.empty())
+    {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return 0;
+    }
+
+    PyObject *result = PyList_New(counts.size());
+    for(int i=0; result && i<counts.size(); i++)
+    {
+        PyList_SET_ITEM(result, i, PyLong_FromUnsignedLongLong((unsigned long long)counts.at(i)));
+    }
+    return result;
+}
+
+// ----- MODULE -----------------------------------------------------------------------------------
+#define MYPYTHON_TRANSFORM(name, tool, doc) \
+    { name, (PyCFunction)(void (*)(void))transform<MyOperation::tool>, METH_VARARGS | METH_KEYWORDS, doc }
+
+static PyMethodDef methods[] = {
+    MYPYTHON_TRANSFORM("negative", Negative, "negative(image, out=None)"),
+    MYPYTHON_TRANSFORM("shift_left", ShiftLeft, "shift_left(image, value, out=None), value in bits"),
+    MYPYTHON_TRANSFORM("shift_right", ShiftRight, "shift_right(image, value, out=None), value in bits"),
+    MYPYTHON_TRANSFORM("scale_up", ScaleUp, "scale_up(image, value, out=None), value is the factor"),
+    MYPYTHON_TRANSFORM("scale_down", ScaleDown, "scale_down(image, value, out=None), value is the factor"),
+    MYPYTHON_TRANSFORM("exponential", Exponential, "exponential(image, out=None)"),
+    MYPYTHON_TRANSFORM("natural_log", NaturalLog, "natural_log(image, out=None)"),
+    MYPYTHON_TRANSFORM("power", Power, "power(image, value, out=None), value is gamma"),
+    MYPYTHON_TRANSFORM("base_log", BaseLog, "base_log(image, value, out=None), value is the base"),
+    MYPYTHON_TRANSFORM("equalize", Equalize, "equalize(image, out=None), uint8 only"),
+    MYPYTHON_TRANSFORM("auto_contrast", AutoContrast, "auto_contrast(image, value, out=None), value is the percent "
+                       "clipped at each end, 0 to below 50, uint8 only"),
+    { "histogram", histogram, METH_VARARGS, "histogram(image) -> list of 256 pixel counts, uint8 only" },
+    { 0, 0, 0, 0 }
+};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT,
+    "imaging_basics",
+    "Point transforms and histograms of the MyImage engine on 2D uint8, uint16 and float32 arrays.\n"
+    "Every transform reads the input through the buffer protocol without copying it, writes into\n"
+    "out (a new array like the input by default, the input itself for in place) and releases the\n"
+    "GIL while it runs.",
+    -1,
+    methods,
+    0, 0, 0, 0
+};
+
+PyMODINIT_FUNC PyInit_imaging_basics()
+{
+    return PyModule_Create(&module);
+}
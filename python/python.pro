@@ -0,0 +1,28 @@
+# python extension module imaging_basics, only built with qmake ImagingBasics.pro CONFIG+=python;
+# PYTHON=... picks the interpreter to build for, numpy is a runtime dependency only. links QtCore
+# and QtGui for QImage but no widgets, put the build directory on PYTHONPATH to import it
+
+QT = core gui
+
+TARGET = imaging_basics
+TEMPLATE = lib
+CONFIG += plugin no_plugin_name_prefix
+CONFIG -= app_bundle
+
+isEmpty(PYTHON): PYTHON = python3
+INCLUDEPATH += $$system("$$PYTHON -c \"import sysconfig; print(sysconfig.get_paths()['include'])\"")
+
+win32 {
+    QMAKE_EXTENSION_SHLIB = pyd
+    LIBS += -L$$system("$$PYTHON -c \"import os, sys; print(os.path.join(sys.base_prefix, 'libs'))\"")
+} else {
+    QMAKE_EXTENSION_SHLIB = so
+}
+
+# the interpreter provides the Python symbols when the module is loaded
+macx: QMAKE_LFLAGS_PLUGIN += -undefined dynamic_lookup
+
+include(../build.pri)
+include(../myimage/myimage-lib.pri)
+
+SOURCES += imaging_basics.cpp
@@ -1,5 +1,25 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
-RESOURCES += \
-    $$PWD/images.qrc
+# the sample images are compiled into images.rcc next to the executable and registered on first
+# use, CONFIG+=embed_samples compiles them into the binary as before
+embed_samples {
+    RESOURCES += \
+        $$PWD/images.qrc
+
+    DEFINES += IMAGING_BASICS_EMBEDDED_SAMPLES
+} else {
+    samples.target = images.rcc
+    samples.commands = $$shell_path($$[QT_HOST_BINS]/rcc) -binary $$shell_path($$PWD/images.qrc) -o images.rcc
+    samples.depends = $$PWD/images.qrc
+
+    QMAKE_EXTRA_TARGETS += samples
+    PRE_TARGETDEPS += images.rcc
+    QMAKE_CLEAN += images.rcc
+
+    macx {
+        samplesBundle.files = $$OUT_PWD/images.rcc
+        samplesBundle.path = Contents/Resources
+        QMAKE_BUNDLE_DATA += samplesBundle
+    }
+}